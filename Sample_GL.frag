@@ -2,13 +2,62 @@
 
 // Interpolated values from the vertex shaders
 in vec3 fragColor;
+in vec3 fragNormal;
+in vec3 fragPosition;
 
 // output data
 out vec3 color;
 
+// Shared by every lit program, see render/lighting.h
+layout (std140) uniform Lighting
+{
+    vec4 lightDirection; // towards the light
+    vec4 lightColor;
+    vec4 ambient;
+    vec4 eye;
+    vec4 specular; // w is the shininess
+    mat4 shadowMatrix;
+    vec4 shadow; // x 1 with a shadow map, y its texel size, z the depth bias
+};
+
+uniform sampler2DShadow shadowMap;
+
+// Fraction of the light reaching the fragment, 2x2 lookups each filtered over 2x2 texels by the hardware
+float lightVisibility()
+{
+    if (shadow.x == 0.0)
+        return 1.0;
+    vec4 light = shadowMatrix * vec4(fragPosition, 1);
+    vec3 coord = light.xyz / light.w * 0.5 + 0.5;
+    if (coord.z > 1.0)
+        return 1.0;
+    float visible = 0.0;
+    for (int x = 0; x < 2; x++)
+        for (int y = 0; y < 2; y++)
+            visible += texture(shadowMap, vec3(coord.xy + (vec2(x, y) - 0.5) * shadow.y, coord.z - shadow.z));
+    return visible * 0.25;
+}
+
 void main()
 {
-    // Output color = color specified in the vertex shader,
-    // interpolated between all 3 surrounding vertices of the triangle
-    color = fragColor;
+    // Objects without normals are left unlit
+    if (dot(fragNormal, fragNormal) == 0.0)
+    {
+        color = fragColor;
+        return;
+    }
+
+    // Blinn-Phong per pixel: the half vector between the light and the eye stands in for the reflection
+    vec3 N = normalize(fragNormal);
+    vec3 L = lightDirection.xyz;
+    vec3 H = normalize(L + normalize(eye.xyz - fragPosition));
+    float diffuse = max(dot(N, L), 0.0);
+    float highlight = diffuse > 0.0 ? pow(max(dot(N, H), 0.0), specular.w) : 0.0;
+    if (diffuse > 0.0)
+    {
+        float visible = lightVisibility();
+        diffuse *= visible;
+        highlight *= visible;
+    }
+    color = fragColor * (ambient.rgb + lightColor.rgb * diffuse) + specular.rgb * lightColor.rgb * highlight;
 }
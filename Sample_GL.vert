@@ -2,12 +2,16 @@
 
 // input data : sent from main program
 layout (location = 0) in vec3 vertexPosition;
-layout (location = 1) in vec3 vertexColor;
+layout (location = 1) in vec3 vertexColor; // per vertex for merged meshes, otherwise set per draw
+layout (location = 2) in vec3 vertexNormal;
 
 uniform mat4 MVP;
+uniform mat4 M;
 
 // output data : used by fragment shader
 out vec3 fragColor;
+out vec3 fragNormal;
+out vec3 fragPosition;
 
 void main ()
 {
@@ -17,6 +21,11 @@ void main ()
     // to produce the color of each fragment
     fragColor = vertexColor;
 
+    // Normal and position in world space, models are only rotated, translated and uniformly scaled
+    // Geometry without a normal attribute reads (0, 0, 0) here
+    fragNormal = mat3(M) * vertexNormal;
+    fragPosition = vec3(M * v);
+
     // Output position of the vertex, in clip space : MVP * position
     gl_Position = MVP * v;
 }
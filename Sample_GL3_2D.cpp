@@ -1,179 +1,54 @@
-#include <iostream>
-#include <cmath>
-#include <fstream>
-#include <map>
-#include <vector>
-#include <sstream>
-#include <stdio.h>
-#include <stdlib.h>
-#include <time.h>
-#include <string.h>
-#include <ctime>
-#include <glad/glad.h>
-#include <GLFW/glfw3.h>
-#include <ao/ao.h>
-#include <mpg123.h>
-#include <sstream>
-#define BITS 8
-#define GLM_FORCE_RADIANS
-#include <glm/glm.hpp>
-#include <glm/gtx/transform.hpp>
-#include <glm/gtc/matrix_transform.hpp>
-
-using namespace std;
-
-struct VAO
-{
-    GLuint VertexArrayID;
-    GLuint VertexBuffer;
-    GLuint ColorBuffer;
+#include "render/camera.h"
+#include "render/queue.h"
+#include "render/shader.h"
+#include "render/upload.h"
+#include "render/pacing.h"
+#include "render/lighting.h"
+#include "render/shadow.h"
+#include "sim/board.h"
+#include "sim/simulation.h"
+#include "sim/latency.h"
+#include "sim/snapshot.h"
+#include "level/level.h"
+#include "level/chunks.h"
+#include "level/gpu_cull.h"
+#include "hud/hud.h"
+#include "audio/music.h"
 
-    GLenum PrimitiveMode;
-    GLenum FillMode;
-    int NumVertices;
-};
-typedef struct VAO VAO;
+GLuint programID;
 
-struct GLMatrices
-{
-    glm::mat4 projectionO, projectionP;
-    glm::mat4 model;
-    glm::mat4 view;
-    GLuint MatrixID;
-} Matrices;
+int right_mouse_clicked = 0, left_mouse_clicked = 0;
 
-struct COLOR
+/* Window and framebuffer sizes and the cursor as last reported by the callbacks,
+ * so a frame reads them from memory instead of querying the windowing system */
+struct WindowMetrics
 {
-    float r;
-    float g;
-    float b;
+    int width, height;     // screen coordinates
+    int fbwidth, fbheight; // pixels
+    double cursorX, cursorY;
 };
 
-typedef struct COLOR color;
-COLOR red = {255 / 255.0, 175 / 255.0, 135 / 255};
-COLOR green = {0.1255, 0.75, 0.333};
-COLOR black = {127 / 255.0, 150 / 255.0, 1.0};
-COLOR steel = {219 / 255.0, 252 / 255.0, 255 / 255.0};
-COLOR yellow = {229 / 255.0, 99 / 255.0, 153 / 255.0};
-COLOR coolblue = {66 / 255.0, 229 / 255.0, 244 / 255.0};
-COLOR coolgreen = {0 / 255.0, 153 / 255.0, 51 / 255.0};
-COLOR grey = {166 / 255.0, 166 / 255.0, 166 / 255.0};
-COLOR teal = {0, 153 / 255.0, 153 / 255.0};
-COLOR bg = {0.3f, 0.3f, 0.3f};
-COLOR blue = {0, 0, 1};
-
-struct Sprite
-{
-    string name;
-    int exists;
-    COLOR color;
-    float x, y, z;
-    float height, width, depth, angle, anglex, angley;
-    VAO *object;
-};
-
-typedef struct Sprite Sprite;
-
-map<string, Sprite> cube;
-map<string, Sprite> tile;
-map<string, Sprite> fragtile;
-map<string, Sprite> bridge;
-map<string, Sprite> toggle;
-map<string, Sprite> teles;
-map <string, Sprite> scoredisp;
-
-GLuint programID;
-int proj_type;
-float goalx = 2, goalz = 0;
-float camera_zoom = 0.2;
-float camera_rotation_angle = 90;
-
-int right_mouse_clicked = 0, left_mouse_clicked = 0, score = 0;
+WindowMetrics windowMetrics;
 
-int vis = 0, blockview = 0, defview = 1, topview = 0, blockangle = 90, followview = 0;
-int standing_bit = 1, move_left = 0, move_right = 0, move_up = 0, move_down = 0,sleeping_x = 0, sleeping_z = 0, move_clock = 0, move_anti = 0;
-int next_left = 90, next_right = -90, next_up = 90, next_down =-90, hor_count = 0, ver_count = 0, next_clock = 90, next_anti = -90,rot_count = 0;
-float cameraxdef = 5, cameraydef = 4, camerazdef = 5, camerax = cameraxdef, cameray = cameraydef, cameraz = camerazdef;
-float targetx = 0, targety = 0, targetz = 0;
-int telcount = 0;
+/* Headless runs (--headless) play the replay in a hidden window without vsync or audio and exit once it
+ * has played out, the makefile's profile training and benchmarks are built on them */
+int headless = 0;
+long headlessFrames = 0;
+double headlessStart, headlessEnd; // GLFW time is gone by the time atexit handlers run
 
-int levelstate = 0;
-
-/* Function to load Shaders - Use it as it is */
-GLuint LoadShaders(const char *vertex_file_path, const char *fragment_file_path)
+/* Registered with atexit, the game also exits on its own after the last level */
+void printHeadlessSummary()
 {
-    // Create the shaders
-    GLuint VertexShaderID = glCreateShader(GL_VERTEX_SHADER);
-    GLuint FragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
-
-    // Read the Vertex Shader code from the file
-    std::string VertexShaderCode;
-    std::ifstream VertexShaderStream(vertex_file_path, std::ios::in);
-    if (VertexShaderStream.is_open())
-    {
-        std::string Line = "";
-        while (getline(VertexShaderStream, Line))
-            VertexShaderCode += "\n" + Line;
-        VertexShaderStream.close();
-    }
-
-    // Read the Fragment Shader code from the file
-    std::string FragmentShaderCode;
-    std::ifstream FragmentShaderStream(fragment_file_path, std::ios::in);
-    if (FragmentShaderStream.is_open())
-    {
-        std::string Line = "";
-        while (getline(FragmentShaderStream, Line))
-            FragmentShaderCode += "\n" + Line;
-        FragmentShaderStream.close();
-    }
-
-    GLint Result = GL_FALSE;
-    int InfoLogLength;
-
-    // Compile Vertex Shader
-    //    printf("Compiling shader : %s\n", vertex_file_path);
-    char const *VertexSourcePointer = VertexShaderCode.c_str();
-    glShaderSource(VertexShaderID, 1, &VertexSourcePointer, NULL);
-    glCompileShader(VertexShaderID);
-
-    // Check Vertex Shader
-    glGetShaderiv(VertexShaderID, GL_COMPILE_STATUS, &Result);
-    glGetShaderiv(VertexShaderID, GL_INFO_LOG_LENGTH, &InfoLogLength);
-    std::vector<char> VertexShaderErrorMessage(InfoLogLength);
-    glGetShaderInfoLog(VertexShaderID, InfoLogLength, NULL, &VertexShaderErrorMessage[0]);
-
-    // Compile Fragment Shader
-    //    printf("Compiling shader : %s\n", fragment_file_path);
-    char const *FragmentSourcePointer = FragmentShaderCode.c_str();
-    glShaderSource(FragmentShaderID, 1, &FragmentSourcePointer, NULL);
-    glCompileShader(FragmentShaderID);
-
-    // Check Fragment ShadercreateRectangle("s1", -1.5, -0.7, -0.5, 0.4, 0.4, 0.4, "toggle", 0, grey);
-    glGetShaderiv(FragmentShaderID, GL_COMPILE_STATUS, &Result);
-    glGetShaderiv(FragmentShaderID, GL_INFO_LOG_LENGTH, &InfoLogLength);
-    std::vector<char> FragmentShaderErrorMessage(InfoLogLength);
-    glGetShaderInfoLog(FragmentShaderID, InfoLogLength, NULL, &FragmentShaderErrorMessage[0]);
-    // fprintf(stdout, "%s\n", &FragmentShaderErrorMessage[0]);
-
-    // Link the program
-    // fprintf(stdout, "Linking program\n");
-    GLuint ProgramID = glCreateProgram();
-    glAttachShader(ProgramID, VertexShaderID);
-    glAttachShader(ProgramID, FragmentShaderID);
-    glLinkProgram(ProgramID);
-
-    // Check the program
-    glGetProgramiv(ProgramID, GL_LINK_STATUS, &Result);
-    glGetProgramiv(ProgramID, GL_INFO_LOG_LENGTH, &InfoLogLength);
-    std::vector<char> ProgramErrorMessage(max(InfoLogLength, int(1)));
-    glGetProgramInfoLog(ProgramID, InfoLogLength, NULL, &ProgramErrorMessage[0]);
-    // fprintf(stdout, "%s\n", &ProgramErrorMessage[0]);
-
-    glDeleteShader(VertexShaderID);
-    glDeleteShader(FragmentShaderID);
-
-    return ProgramID;
+    double seconds = headlessEnd - headlessStart;
+    printf("headless: %ld frames in %.2f s, %.3f ms per frame\n", headlessFrames, seconds,
+           headlessFrames ? 1000 * seconds / headlessFrames : 0.0);
+    printRenderStats();
+    printPacingStats();
+    printShadowStats();
+    printGpuCullStats();
+    printLevelStats();
+    if (!latency.swap.empty() || latency.buffered)
+        printLatencyStats();
 }
 
 static void error_callback(int error, const char *description)
@@ -181,88 +56,10 @@ static void error_callback(int error, const char *description)
     fprintf(stderr, "Error: %s\n", description);
 }
 
+/* Ends the main loop, which shuts everything down once the frame is done, so key callbacks can call it */
 void quit(GLFWwindow *window)
 {
-    glfwDestroyWindow(window);
-    glfwTerminate();
-    exit(EXIT_SUCCESS);
-}
-
-/* Generate VAO, VBOs and return VAO handle */
-struct VAO *create3DObject(GLenum primitive_mode, int numVertices, const GLfloat *vertex_buffer_data, const GLfloat *color_buffer_data, GLenum fill_mode = GL_FILL)
-{
-    struct VAO *vao = new struct VAO;
-    vao->PrimitiveMode = primitive_mode;
-    vao->NumVertices = numVertices;
-    vao->FillMode = fill_mode;
-
-    // Create Vertex Array Object
-    // Should be done after CreateWindow and before any other GL calls
-    glGenVertexArrays(1, &(vao->VertexArrayID)); // VAO
-    glGenBuffers(1, &(vao->VertexBuffer));       // VBO - vertices
-    glGenBuffers(1, &(vao->ColorBuffer));        // VBO - colors
-
-    glBindVertexArray(vao->VertexArrayID);                                                                // Bind the VAO
-    glBindBuffer(GL_ARRAY_BUFFER, vao->VertexBuffer);                                                     // Bind the VBO vertices
-    glBufferData(GL_ARRAY_BUFFER, 3 * numVertices * sizeof(GLfloat), vertex_buffer_data, GL_STATIC_DRAW); // Copy the vertices into VBO
-    glVertexAttribPointer(
-        0,        // attribute 0. Vertices
-        3,        // size (x,y,z)
-        GL_FLOAT, // type
-        GL_FALSE, // normalized?
-        0,        // stride
-        (void *)0 // array buffer offset
-        );
-
-    glBindBuffer(GL_ARRAY_BUFFER, vao->ColorBuffer);                                                     // Bind the VBO colors
-    glBufferData(GL_ARRAY_BUFFER, 3 * numVertices * sizeof(GLfloat), color_buffer_data, GL_STATIC_DRAW); // Copy the vertex colors
-    glVertexAttribPointer(
-        1,        // attribute 1. Color
-        3,        // size (r,g,b)
-        GL_FLOAT, // type
-        GL_FALSE, // normalized?
-        0,        // stride
-        (void *)0 // array buffer offset
-        );
-
-    return vao;
-}
-
-/* Generate VAO, VBOs and return VAO handle - Common Color for all vertices */
-struct VAO *create3DObject(GLenum primitive_mode, int numVertices, const GLfloat *vertex_buffer_data, const GLfloat red, const GLfloat green, const GLfloat blue, GLenum fill_mode = GL_FILL)
-{
-    GLfloat *color_buffer_data = new GLfloat[3 * numVertices];
-    for (int i = 0; i < numVertices; i++)
-    {
-        color_buffer_data[3 * i] = red;
-        color_buffer_data[3 * i + 1] = green;
-        color_buffer_data[3 * i + 2] = blue;
-    }
-
-    return create3DObject(primitive_mode, numVertices, vertex_buffer_data, color_buffer_data, fill_mode);
-}
-
-/* Render the VBOs handled by VAO */
-void draw3DObject(struct VAO *vao)
-{
-    // Change the Fill Mode for this object
-    glPolygonMode(GL_FRONT_AND_BACK, vao->FillMode);
-
-    // Bind the VAO to use
-    glBindVertexArray(vao->VertexArrayID);
-
-    // Enable Vertex Attribute 0 - 3d Vertices
-    glEnableVertexAttribArray(0);
-    // Bind the VBO to use
-    glBindBuffer(GL_ARRAY_BUFFER, vao->VertexBuffer);
-
-    // Enable Vertex Attribute 1 - Color
-    glEnableVertexAttribArray(1);
-    // Bind the VBO to use
-    glBindBuffer(GL_ARRAY_BUFFER, vao->ColorBuffer);
-
-    // Draw the geometry !
-    glDrawArrays(vao->PrimitiveMode, 0, vao->NumVertices); // Starting from vertex 0; 3 vertices total -> 1 triangle
+    glfwSetWindowShouldClose(window, 1);
 }
 
 /**************************
@@ -273,7 +70,7 @@ void draw3DObject(struct VAO *vao)
 /* Prefered for Keyboard events */
 void scroll_callback(GLFWwindow *window, double xoffset, double yoffset)
 {
-    camera_zoom += yoffset / 10;
+    zoomCamera(yoffset / 10);
 }
 
 void keyboard(GLFWwindow *window, int key, int scancode, int action, int mods)
@@ -308,30 +105,10 @@ void keyboardChar(GLFWwindow *window, unsigned int key)
     switch (key)
     {
     case 'o':
-        if(blockview == 1)
-        {
-            blockangle += 5;
-            targetx = 1 * cos(blockangle * M_PI / 180) + cube["maincube"].x;
-            targety = 0;
-            targetz = 1 * sin(blockangle * M_PI / 180) + cube["maincube"].z;
-        }
-        else
-        {
-            camera_rotation_angle += 5;
-        }
+        turnCamera(5);
         break;
     case 'p':
-        if(blockview == 1)
-        {
-            blockangle -= 5;
-            targetx = 1 * cos(blockangle * M_PI / 180) + cube["maincube"].x;
-            targety = 0;
-            targetz = 1 * sin(blockangle * M_PI / 180) + cube["maincube"].z;
-        }
-        else
-        {
-            camera_rotation_angle -= 5;
-        }
+        turnCamera(-5);
         break;
     case 'Q':
     case 'q':
@@ -340,106 +117,37 @@ void keyboardChar(GLFWwindow *window, unsigned int key)
     case ' ':
         proj_type ^= 1;
         break;
-    case 'a':
-        move_left = 1;
-        score += 1;
+    case 'i':
+        printRenderStats();
+        printLevelStats();
+        printStreamStats();
+        readGpuCullStats();
+        printGpuCullStats();
+        printTextStats();
+        printCameraStats();
+        printPacingStats();
+        printLatencyStats();
+        printLightingStats();
+        printShadowStats();
         break;
-    case 'd':
-        move_right = 1;
-        score += 1;
+    case 'v':
+        splitscreen ^= 1;
         break;
+    case 'a':
+    case 'd':
     case 'w':
-        move_up = 1;
-        score += 1;
-        break;
     case 's':
-        move_down = 1;
-        score += 1;
+        // Moves are buffered and picked up by the simulation once the current roll ends
+        pushInputEvent(moveForKey(key), glfwGetTime());
         break;
     case 'f':
-        if(camerax == cameraxdef && cameray == cameraydef && cameraz == camerazdef)
-        {
-            if(standing_bit == 1)
-            {
-                camerax = cube["maincube"].x;
-                cameray = cube["maincube"].y + 0.5;
-                cameraz = cube["maincube"].z;
-            }
-            else
-            {
-                camerax = cube["maincube"].x;
-                cameray = cube["maincube"].y + 0.25;
-                cameraz = cube["maincube"].z;
-            }
-            blockview = 1;
-            defview = 0;
-            camera_rotation_angle = 0;
-            targetx = 0;
-            targety = 0;
-            targetz = 0;
-        }
-        else
-        {
-            camerax = cameraxdef;
-            cameray = cameraydef;
-            cameraz = camerazdef;
-            blockview = 0;
-            defview = 1;
-            camera_rotation_angle = 90;
-            targetx = 0;
-            targety = 0;
-            targetz = 0;
-        }
+        toggleCameraMode(CAMERA_BLOCK);
         break;
     case 'r':
-        if(camerax == cameraxdef && cameray == cameraydef && cameraz == camerazdef)
-        {
-            camerax = 0;
-            cameray = 6;
-            cameraz = 0;
-            topview = 1;
-            defview = 0;
-            targetx = 1;
-            targety = -0.5;
-        }
-        else
-        {
-            camerax = cameraxdef;
-            cameray = cameraydef;
-            cameraz = camerazdef;
-            topview = 0;
-            defview = 1;
-            camera_rotation_angle = 90;
-            targetx = 0;
-            targety = 0;
-            targetz = 0;
-        }
+        toggleCameraMode(CAMERA_TOP);
         break;
     case 'b':
-        if(camerax == cameraxdef && cameray == cameraydef && cameraz == camerazdef)
-        {
-            camerax = cube["maincube"].x - 3;
-            cameray = 2;
-            cameraz = cube["maincube"].z;
-            targetx = cube["maincube"].x;
-            targetz = cube["maincube"].z;
-            targety = 1.7;
-            defview = 0;
-            followview = 1;
-            camera_rotation_angle = 0;
-        }
-        else
-        {
-            camerax = cameraxdef;
-            cameray = cameraydef;
-            cameraz = camerazdef;
-            followview = 0;
-            defview = 1;
-            camera_rotation_angle = 90;
-            targetx = 0;
-            targety = 0;
-            targetz = 0;
-        }
+        toggleCameraMode(CAMERA_FOLLOW);
         break;
     default:
         break;
@@ -478,275 +186,83 @@ void mouseButton (GLFWwindow* window, int button, int action, int mods)
 	}
 }
 
-/* Executed when window is resized to 'width' and 'height' */
+/* Executed when the cursor moves, in screen coordinates */
+void cursorMoved(GLFWwindow *window, double x, double y)
+{
+    windowMetrics.cursorX = x;
+    windowMetrics.cursorY = y;
+}
+
+/* Executed when window is resized, in screen coordinates */
+void windowResized(GLFWwindow *window, int width, int height)
+{
+    windowMetrics.width = width;
+    windowMetrics.height = height;
+}
+
+/* Executed when the framebuffer is resized to 'fbwidth' and 'fbheight' pixels */
 /* Modify the bounds of the screen here in glm::ortho or Field of View in glm::Perspective */
-void reshapeWindow(GLFWwindow *window, int width, int height)
+void reshapeWindow(GLFWwindow *window, int fbwidth, int fbheight)
 {
-    int fbwidth = width, fbheight = height;
-    glfwGetFramebufferSize(window, &fbwidth, &fbheight);
+    windowMetrics.fbwidth = fbwidth;
+    windowMetrics.fbheight = fbheight;
+    // A minimized window has no framebuffer, keep the projections for when it comes back
+    if (fbwidth <= 0 || fbheight <= 0)
+        return;
 
     GLfloat fov = M_PI / 2;
 
     // sets the viewport of openGL renderer
-    glViewport(0, 0, (GLsizei)fbwidth, (GLsizei)fbheight);
+    setViewport(0, 0, fbwidth, fbheight);
 
     // Store the projection matrix in a variable for future use
     // Perspective projection for 3D views
     Matrices.projectionP = glm::perspective(fov, (GLfloat)fbwidth / (GLfloat)fbheight, 0.1f, 500.0f);
+    Matrices.projectionPSplit = glm::perspective(fov, (GLfloat)(fbwidth / 2) / (GLfloat)fbheight, 0.1f, 500.0f);
 
     // Ortho projection for 2D views
     Matrices.projectionO = glm::ortho(-4.0f, 4.0f, -4.0f, 4.0f, 0.1f, 500.0f);
+    markCameraDirty();
 }
 
-VAO *triangle, *rectangle;
-
-// Creates the triangle object used in this sample code
-void createTriangle()
+/* Draws the state of the given snapshot, the live simulation state belongs to the simulation thread */
+void draw(GLFWwindow *window, const SimSnapshot &snapshot)
 {
-    /* ONLY vertices between the bounds specified in glm::ortho will be visible on screen */
-
-    /* Define vertex array as used in glBegin (GL_TRIANGLES) */
-    static const GLfloat vertex_buffer_data[] = {
-        0, 0, 0,  // vertex 0
-        -1, 1, 0, // vertex 1
-        -1, 0, 0, // vertex 2
-    };
-
-    static const GLfloat color_buffer_data[] = {
-        1, 0, 0, // color 0
-        1, 0, 0, // color 1
-        1, 0, 0, // color 2
-    };
-
-    // create3DObject creates and returns a handle to a VAO that can be used later
-    triangle = create3DObject(GL_TRIANGLES, 3, vertex_buffer_data, color_buffer_data, GL_FILL);
-}
+    double scene_start = glfwGetTime();
+    int fbwidth = windowMetrics.fbwidth, fbheight = windowMetrics.fbheight;
 
-// Creates the rectangle object used in this sample code
-void createRectangle(string name, float x, float y, float z, float width, float height, float depth, string type, float angle, COLOR mycolor)
-{
-    float w = width / 2;
-    float h = height / 2;
-    float d = depth / 2;
-    // GL3 accepts only Triangles. Quads are not supported
-    GLfloat vertex_buffer_data[] = {
-        -w, -h, -d, // triangle 1 : begin
-        -w, -h, d,
-        -w, h, d, // triangle 1 : end
-        w, h, -d, // triangle 2 : begin
-        -w, -h, -d,
-        -w, h, -d, // triangle 2 : end
-        w, -h, d,
-        -w, -h, -d,
-        w, -h, -d,
-        w, h, -d,
-        w, -h, -d,
-        -w, -h, -d,
-        -w, -h, -d,
-        -w, h, d,
-        -w, h, -d,
-        w, -h, d,
-        -w, -h, d,
-        -w, -h, -d,
-        -w, h, d,
-        -w, -h, d,
-        w, -h, d,
-        w, h, d,
-        w, -h, -d,
-        w, h, -d,
-        w, -h, -d,
-        w, h, d,
-        w, -h, d,
-        w, h, d,
-        w, h, -d,
-        -w, h, -d,
-        w, h, d,
-        -w, h, -d,
-        -w, h, d,
-        w, h, d,
-        -w, h, d,
-        w, -h, d};
-
-    if (type == "cube")
-    {
-        GLfloat color_buffer_data[] =
-            {
-                blue.r, blue.g, blue.b,             // color 1
-                coolblue.r, coolblue.g, coolblue.b, // color 2
-                blue.r, blue.g, blue.b,             // color 1
-                coolblue.r, coolblue.g, coolblue.b, // color 2
-                blue.r, blue.g, blue.b,             // color 1
-                coolblue.r, coolblue.g, coolblue.b, // color 2
-                blue.r, blue.g, blue.b,             // color 1
-                coolblue.r, coolblue.g, coolblue.b, // color 2
-                blue.r, blue.g, blue.b,             // color 1
-                coolblue.r, coolblue.g, coolblue.b, // color 2
-                blue.r, blue.g, blue.b,             // color 1
-                coolblue.r, coolblue.g, coolblue.b, // color 2
-                blue.r, blue.g, blue.b,             // color 1
-                coolblue.r, coolblue.g, coolblue.b, // color 2
-                blue.r, blue.g, blue.b,             // color 1
-                coolblue.r, coolblue.g, coolblue.b, // color 2
-                blue.r, blue.g, blue.b,             // color 1
-                coolblue.r, coolblue.g, coolblue.b, // color 2
-                blue.r, blue.g, blue.b,             // color 1
-                coolblue.r, coolblue.g, coolblue.b, // color 2
-                blue.r, blue.g, blue.b,             // color 1
-                coolblue.r, coolblue.g, coolblue.b, // color 2
-                blue.r, blue.g, blue.b,             // color 1
-                coolblue.r, coolblue.g, coolblue.b, // color 2
-                blue.r, blue.g, blue.b,             // color 1
-                coolblue.r, coolblue.g, coolblue.b, // color 2
-                blue.r, blue.g, blue.b,             // color 1
-                coolblue.r, coolblue.g, coolblue.b, // color 2
-                blue.r, blue.g, blue.b,             // color 1
-                coolblue.r, coolblue.g, coolblue.b, // color 2
-                blue.r, blue.g, blue.b,             // color 1
-                coolblue.r, coolblue.g, coolblue.b, // color 2
-                blue.r, blue.g, blue.b,             // color 1
-                coolblue.r, coolblue.g, coolblue.b, // color 2
-                blue.r, blue.g, blue.b,             // color 1
-                coolblue.r, coolblue.g, coolblue.b  // color 2
-            };
-        rectangle = create3DObject(GL_TRIANGLES, 36, vertex_buffer_data, color_buffer_data, GL_FILL);
-    }
-    else
-    {
-        GLfloat color_buffer_data[] = {
-            mycolor.r, mycolor.g, mycolor.b, // color 1
-            mycolor.r, mycolor.g, mycolor.b, // color 2
-            mycolor.r, mycolor.g, mycolor.b, // color 3
-            mycolor.r, mycolor.g, mycolor.b, // color 4
-            mycolor.r, mycolor.g, mycolor.b, // color 5
-            mycolor.r, mycolor.g, mycolor.b, // color 6
-            mycolor.r, mycolor.g, mycolor.b, // color 1
-            mycolor.r, mycolor.g, mycolor.b, // color 2
-            mycolor.r, mycolor.g, mycolor.b, // color 3
-            mycolor.r, mycolor.g, mycolor.b, // color 4
-            mycolor.r, mycolor.g, mycolor.b, // color 5
-            mycolor.r, mycolor.g, mycolor.b, // color 6
-            mycolor.r, mycolor.g, mycolor.b, // color 1
-            mycolor.r, mycolor.g, mycolor.b, // color 2
-            mycolor.r, mycolor.g, mycolor.b, // color 3
-            mycolor.r, mycolor.g, mycolor.b, // color 4
-            mycolor.r, mycolor.g, mycolor.b, // color 5
-            mycolor.r, mycolor.g, mycolor.b, // color 6
-            mycolor.r, mycolor.g, mycolor.b, // color 1
-            mycolor.r, mycolor.g, mycolor.b, // color 2
-            mycolor.r, mycolor.g, mycolor.b, // color 3
-            mycolor.r, mycolor.g, mycolor.b, // color 4
-            mycolor.r, mycolor.g, mycolor.b, // color 5
-            mycolor.r, mycolor.g, mycolor.b, // color 6
-            mycolor.r, mycolor.g, mycolor.b, // color 1
-            mycolor.r, mycolor.g, mycolor.b, // color 2
-            mycolor.r, mycolor.g, mycolor.b, // color 3
-            mycolor.r, mycolor.g, mycolor.b, // color 4
-            mycolor.r, mycolor.g, mycolor.b, // color 5
-            mycolor.r, mycolor.g, mycolor.b, // color 6
-            mycolor.r, mycolor.g, mycolor.b, // color 1
-            mycolor.r, mycolor.g, mycolor.b, // color 2
-            mycolor.r, mycolor.g, mycolor.b, // color 3
-            mycolor.r, mycolor.g, mycolor.b, // color 4
-            mycolor.r, mycolor.g, mycolor.b, // color 5
-            mycolor.r, mycolor.g, mycolor.b  // color 6
-        };
-        rectangle = create3DObject(GL_TRIANGLES, 36, vertex_buffer_data, color_buffer_data, GL_FILL);
-    }
-
-    // create3DObject creates and returns a handle to a VAO that can be used later
-    Sprite elem = {};
-    elem.exists = 1;
-    elem.name = name;
-    elem.object = rectangle;
-    elem.x = x;
-    elem.y = y;
-    elem.z = z;
-    elem.height = height;
-    elem.width = width;
-    elem.depth = depth;
-    elem.angle = angle;
-    elem.anglex = 0;
-    elem.angley = 0;
-
-    if (type == "cube")
-    {
-        cube[name] = elem;
-    }
-    else if (type == "tile")
-    {
-        tile[name] = elem;
-    }
-    else if (type == "bridge")
-    {
-        elem.exists = 0;
-        bridge[name] = elem;
-    }
-    else if (type == "toggle")
+    // Dragging across the whole window is one full turn, whatever size it was resized to
+    if (left_mouse_clicked == 1 && windowMetrics.width > 0)
     {
-        toggle[name] = elem;
-    }
-    else if (type == "fragtile")
-    {
-        fragtile[name] = elem;
-    }
-    else if(type == "teles")
-    {
-        teles[name] = elem;
-    }
-    else if(type == "scoredisp")
-    {
-        scoredisp[name] = elem;
-    }
-}
-
-/* Render the scene with openGL */
-/* Edit this function according to your assignment */
-void startnextlevel()
-{
-    cube["maincube"].x = -3.5;
-    cube["maincube"].y = -0.15;
-    cube["maincube"].z = 0;
-    toggle["s1"].exists = 0;
-    bridge["s1"].exists = 0;
-    bridge["s12"].exists = 0;
-
-    createRectangle("teleport", -1.5, -0.7, -0.5, 0.4, 2, 0.4, "teles", 0, red);
-}
-
-void draw(GLFWwindow *window, float x, float y, float w, float h)
-{
-    int fbwidth, fbheight;
-    glfwGetFramebufferSize(window, &fbwidth, &fbheight);
-    glViewport((int)(x * fbwidth), (int)(y * fbheight), (int)(w * fbwidth), (int)(h * fbheight));
-
-    double new_mouse_x, new_mouse_y;
-    glfwGetCursorPos(window, &new_mouse_x, &new_mouse_y);
-    if (left_mouse_clicked == 1)
-    {
-        camera_rotation_angle = (new_mouse_x * 360 / 600.0);
-        camerax = cameraxdef;
-        cameraz = cameraydef;
+        setCameraOrbit(windowMetrics.cursorX * 360 / windowMetrics.width);
     }
     // use the loaded shader program
     // Don't change unless you know what you are doing
     glUseProgram(programID);
 
-    // Eye - Location of camera. Don't change unless you are sure!!
-    glm::vec3 eye(camerax * cos(camera_rotation_angle * M_PI / 180.0f), cameray, cameraz * sin(camera_rotation_angle * M_PI / 180.0f));
-    // Target - Where is the camera looking at.  Don't change unless you are sure!!
-    glm::vec3 target(targetx, targety, targetz);
-    // Up - Up vector defines tilt of camera.  Don't change unless you are sure!!
-    glm::vec3 up(0, 1, 0);
-
-    // Compute Camera matrix (view)
-    // Matrices.view = glm::lookAt( eye, target, up ); // Rotating Camera for 3D
-    //  Don't change unless you are sure!!
-    Matrices.view = glm::lookAt(eye, target, up); // Fixed camera for 2D (ortho) in XY plane
-
-    // Compute ViewProject matrix as view/camera might not be changed for this frame (basic scenario)
-    //  Don't change unless you are sure!!
-    glm::mat4 VP = (proj_type ? Matrices.projectionP : Matrices.projectionO) * Matrices.view * glm::scale(glm::vec3(exp(camera_zoom)));
+    // The camera eases between views and follows the block, its view projections are cached
+    // and only rebuilt when the eye, target, zoom or a projection changed
+    // Standing the eye is at the top of the block, lying at its middle
+    const BlockPose &block = snapshot.block;
+    float blockEyeHeight = block.state.orientation == ORIENT_STANDING ? 0.5 : 0.25;
+    updateCamera(glfwGetTime(), block.position, blockEyeHeight);
 
+    // Split screen renders orthographic on the left and perspective on the right
+    vector<RenderView> views;
+    if (splitscreen)
+    {
+        RenderView left = {0, 0, fbwidth / 2, fbheight, cameraViewProjection(CAMERA_ORTHO)};
+        RenderView right = {fbwidth / 2, 0, fbwidth - fbwidth / 2, fbheight, cameraViewProjection(CAMERA_PERSPECTIVE_SPLIT)};
+        views.push_back(left);
+        views.push_back(right);
+    }
+    else
+    {
+        RenderView full = {0, 0, fbwidth, fbheight, cameraViewProjection(proj_type ? CAMERA_PERSPECTIVE : CAMERA_ORTHO)};
+        views.push_back(full);
+    }
+    glm::mat4 VP = views[0].VP;
+    beginRenderQueue(VP);
 
     // Send our transformation to the currently bound shader, in the "MVP" uniform
     // For each model you render, since the MVP will be different (at least the M part)
@@ -768,968 +284,142 @@ void draw(GLFWwindow *window, float x, float y, float w, float h)
     // Increment angles
     // float increments = 1;
 
-    if(blockview == 1)
-    {
-        if(standing_bit == 1)
-        {
-            camerax = cube["maincube"].x;
-            cameray = cube["maincube"].y + 0.5;
-            cameraz = cube["maincube"].z;
-        }
-        else
-        {
-            camerax = cube["maincube"].x;
-            cameray = cube["maincube"].y + 0.25;
-            cameraz = cube["maincube"].z;
-        }
-        targetx = 1 * cos(blockangle * M_PI / 180) + cube["maincube"].x;
-        targety = 0;
-        targetz = 1 * sin(blockangle * M_PI / 180) + cube["maincube"].z;
-    }
-    else if(defview == 1)
+    // Frames fall between ticks, the block is carried forward by the time since the snapshot's last tick
+    // The simulation moves the block, the cube sprite only gives its mesh and color
+    glm::mat4 blockModel(1.0f);
+    const Sprite *blockSprite = findSprite(cube, "maincube");
+    if (blockSprite && blockSprite->exists)
     {
-        camerax = cameraxdef;
-        cameray = cameraydef;
-        cameraz = camerazdef;
-        targetx = 0;
-        targety = 0;
-        targetz = 0;
-    }
-    else if(topview == 1)
-    {
-        camerax = 0;
-        cameray = 6;
-        cameraz = 0;
-        targetx = 1;
-        targety = -0.5;
-    }
-    else if(followview == 1)
-    {
-        camerax = cube["maincube"].x - 3;
-        cameray = 2;
-        cameraz = cube["maincube"].z;
-        targetx = cube["maincube"].x;
-        targetz = cube["maincube"].z;
-        targety = 1.7;
-        camera_rotation_angle = 0;
-    }
-    for(map<string, Sprite>::iterator it = cube.begin(); it != cube.end(); it++)
-    {
-        int flag = 0;
-        string current = it->first;
-        if(cube[current].exists == 0)
-        {
-            continue;
-        }
-        if(move_left == 1 && cube[current].anglex < next_left && standing_bit == 1)
-        {
-            if(vis == 0)
-            {
-                hor_count--;
-                vis = 1;
-            }
-            cube[current].y -= 0.025;
-            cube[current].x -= 0.075;
-            cube[current].anglex += 9;
-            if(cube[current].anglex == next_left)
-            {
-                move_left = 0;
-                standing_bit = 0;
-                sleeping_x = 1;
-                sleeping_z = 0;
-                next_left += 90;
-                next_right += 90;
-                vis = 0;
-            }
-        }
-        else if(move_left == 1 && cube[current].anglex < next_left && /*standing_bit == 0*/ sleeping_x == 1)
-        {
-            if(vis == 0)
-            {
-                hor_count--;
-                vis = 1;
-            }
-            cube[current].y += 0.025;
-            cube[current].x -= 0.075;
-            cube[current].anglex += 9;
-            if(cube[current].anglex == next_left)
-            {
-                move_left = 0;
-                standing_bit = 1;
-                next_left += 90;
-                next_right += 90;
-                sleeping_x = 0;
-                sleeping_z = 0;
-                vis = 0;
-            }
-        }
-        else if(move_left == 1 && cube[current].angle > next_anti && sleeping_z == 1)
-        {
-            if(vis == 0)
-            {
-                vis = 1;
-                rot_count--;
-            }
-            cube[current].x -= 0.05;
-            cube[current].angle -= 9;
-            if(cube[current].angle == next_anti)
-            {
-                move_left = 0;
-                next_clock -= 90;
-                next_anti -= 90;
-                sleeping_x = 0;
-                standing_bit = 0;
-                vis = 0;
-            }
-        }
-        else if(move_right == 1 && cube[current].anglex > next_right && standing_bit == 1)
-        {
-            if(vis == 0)
-            {
-                hor_count++;
-                vis = 1;
-            }
-            cube[current].y -= 0.025;
-            cube[current].x += 0.075;
-            cube[current].anglex -= 9;
-            if(cube[current].anglex == next_right)
-            {
-                standing_bit = 0;
-                move_right = 0;
-                next_right -= 90;
-                next_left -= 90;
-                sleeping_x = 1;
-                sleeping_z = 0;
-                vis = 0;
-            }
-        }
-        else if(move_right == 1 && cube[current].anglex > next_right && sleeping_x == 1)
-        {
-            if(vis == 0)
-            {
-                hor_count++;
-                vis = 1;
-            }
-            cube[current].y += 0.025;
-            cube[current].x += 0.075;
-            cube[current].anglex -= 9;
-            if(cube[current].anglex == next_right)
-            {
-                standing_bit = 1;
-                move_right = 0;
-                next_right -= 90;
-                next_left -= 90;
-                sleeping_x = 0;
-                sleeping_z = 0;
-                vis = 0;
-            }
-        }
-        else if(move_right == 1 && cube[current].angle < next_clock && sleeping_z == 1)
-        {
-            if(vis == 0)
-            {
-                rot_count++;
-                vis = 1;
-            }
-            cube[current].x += 0.05;
-            cube[current].angle += 9;
-            if(cube[current].angle == next_clock)
-            {
-                move_right = 0;
-                next_clock += 90;
-                next_anti += 90;
-                sleeping_x = 0;
-                standing_bit = 0;
-                vis = 0;
-            }
-        }
-        else if(move_up == 1 && cube[current].angley > next_down && standing_bit == 1)
-        {
-            cube[current].z -= 0.075;
-            cube[current].y -= 0.025;
-            cube[current].angley -= 9;
-            if (cube[current].angley == next_down)
-            {
-                standing_bit = 0;
-                sleeping_x = 0;
-                sleeping_z = 1;
-                move_up = 0;
-                next_up -= 90;
-                next_down -= 90;
-            }
-        }
-        else if(move_up == 1 && cube[current].angley > next_down && sleeping_z == 1)
-        {
-            cube[current].z -= 0.075;
-            cube[current].y += 0.025;
-            cube[current].angley -= 9;
-            if(cube[current].angley == next_down)
-            {
-                standing_bit = 1;
-                sleeping_x = 0;
-                sleeping_z = 0;
-                move_up = 0;
-                next_up -= 90;
-                next_down -= 90;
-            }
-        }
-        else if(move_up == 1 && cube[current].angle < next_clock && sleeping_x == 1)
-        {
-            cube[current].z -= 0.05;
-            cube[current].angle += 9;
-            if(cube[current].angle == next_clock)
-            {
-                move_up = 0;
-                next_clock += 90;
-                next_anti += 90;
-            }
-        }
-        else if(move_down == 1 && cube[current].angley < next_up && standing_bit == 1)
-        {
-            cube[current].z += 0.075;
-            cube[current].y -= 0.025;
-            cube[current].angley += 9;
-            if(cube[current].angley == next_up)
-            {
-                standing_bit = 0;
-                sleeping_x = 0;
-                sleeping_z = 1;
-                move_down = 0;
-                next_up += 90;
-                next_down += 90;
-            }
-        }
-        else if(move_down == 1 && cube[current].angley < next_up && sleeping_z == 1)
-        {
-            cube[current].z += 0.075;
-            cube[current].y += 0.025;
-            cube[current].angley += 9;
-            if (cube[current].angley == next_up)
-            {
-                standing_bit = 1;
-                sleeping_x = 0;
-                sleeping_z = 1;
-                move_down = 0;
-                next_up += 90;
-                next_down += 90;
-            }
-        }
-        else if (move_down == 1 && cube[current].angle > next_anti && sleeping_x == 1)
-        {
-            cube[current].z += 0.05;
-            cube[current].angle -= 9;
-            if (cube[current].angle == next_anti)
-            {
-                move_down = 0;
-                next_clock -= 90;
-                next_anti -= 90;
-            }
-        }
-        cube[current].x = roundf(cube[current].x * 100000) / 100000.0;
-        cube[current].z = roundf(cube[current].z * 100000) / 100000.0;
-        if (cube[current].x == goalx && cube[current].z == goalz && move_left == 0 && move_right == 0 && move_up == 0 && move_down == 0)
-        {
-            cout << "You've won" << endl;
-            if (levelstate == 0)
-            {
-                cout << "NEXT LEVEL" << endl;
-            }
-            levelstate++;
-            startnextlevel();
-            if (levelstate > 1)
-            {
-                cout<<"That's all folks!"<<endl;
-                exit(0);
-            }
-        }
-
-        for(map<string, Sprite>::iterator it1 = tile.begin(); it1 != tile.end(); it1++)
-        {
-            string curr = it1->first;
-            if(tile[curr].exists == 0)
-            {
-                continue;
-            }
-            if(abs(tile[curr].x - cube[current].x) <= 0.25 && abs(tile[curr].z - cube[current].z) <= 0.25)
-            {
-                flag = 1;
-                break;
-            }
-        }
-        for(map<string, Sprite>::iterator it1 = fragtile.begin(); it1 != fragtile.end(); it1++)
-        {
-            string curr = it1->first;
-            if(fragtile[curr].exists == 0)
-            {
-                continue;
-            }
-            if((abs(fragtile[curr].x - cube[current].x) <= 0.25 && abs(fragtile[curr].z - cube[current].z) <= 0.25) && move_left == 0 && move_right == 0 && move_up == 0 && move_down == 0)
-            {
-                if(standing_bit && move_left == 0 && move_right == 0 && move_up == 0 && move_down == 0)
-                {
-                    if(abs(fragtile[curr].x - cube[current].x) < 0.01 && abs(fragtile[curr].z - cube[current].z) < 0.01)
-                    {
-                        flag = 0;
-                    }
-                    else
-                        flag = 1;
-                }
-                else
-                {
-                    flag = 1;
-                }
-            }
-            else if((abs(fragtile[curr].x - cube[current].x) <= 0.25 && abs(fragtile[curr].z - cube[current].z) <= 0.25))
-            {
-                flag = 1;
-            }
-        }
-        for(map<string, Sprite>::iterator it1 = teles.begin(); it1 != teles.end(); it1++)
-        {
-            string curr = it1->first;
-            if(teles[curr].exists == 0)
-            {
-                continue;
-            }
-            if((abs(teles[curr].x - cube[current].x) <= 0.25 && abs(teles[curr].z - cube[current].z) <= 0.25) && move_left == 0 && move_right == 0 && move_up == 0 && move_down == 0)
-            {
-                if(standing_bit && move_left == 0 && move_right == 0 && move_up == 0 && move_down == 0)
-                {
-                    if(abs(teles[curr].x - cube[current].x) < 0.001 && abs(teles[curr].z - cube[current].z) < 0.001)
-                    {
-                        while(telcount <= 100)
-                        {
-                            telcount++;
-                            float temp = cube["maincube"].y;
-                            cube["maincube"].y = cube["maincube"].y + 0.5;
-                            if(cube["maincube"].y >= 3)
-                            {
-                                cube["maincube"].y = temp;
-                            }
-                            if(telcount < 100)
-                            {
-                                glm::mat4 MVP; // MVP = Projection * View * Model
-                                Matrices.model = glm::mat4(1.0f);
-                                glm::mat4 ObjectTransform;
-                                glm::mat4 translateObject = glm::translate(glm::vec3(cube[current].x, cube[current].y, cube[current].z));    // glTranslatef
-                                glm::mat4 rotateTriangle = glm::rotate((float)((cube[current].anglex) * M_PI / 180.0f), glm::vec3(0, 0, 1)); // rotate about vector (1,0,0)
-                                glm::mat4 rotateTriangle1 = glm::rotate((float)((cube[current].angley) * M_PI / 180.0f), glm::vec3(1, 0, 0));
-                                glm::mat4 rotateTriangle2 = glm::rotate((float)((cube[current].angle) * M_PI / 180.0f), glm::vec3(0, 1, 0)); // rotate about vector (1,0,0)
-
-                                ObjectTransform = translateObject * rotateTriangle * rotateTriangle1 * rotateTriangle2;
-                                Matrices.model *= ObjectTransform;
-                                MVP = VP * Matrices.model; // MVP = p * V * M
-
-                                glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-                                draw3DObject(cube[current].object);
-                            }
-                        }
-                        cube["maincube"].x = 3.5;
-                        cube["maincube"].y = -0.15;
-                        cube["maincube"].z = 0;
-                        flag = 1;
-                    }
-                    else
-                    {
-                        flag = 1;
-                    }
-                }
-                else
-                {
-                    flag = 1;
-                }
-            }
-            else if((abs(teles[curr].x - cube[current].x) <= 0.25 && abs(teles[curr].z - cube[current].z) <= 0.25))
-            {
-                flag = 1;
-            }
-        }
-        for(map<string, Sprite>::iterator it1 = toggle.begin(); it1 != toggle.end(); it1++)
-        {
-            string curr = it1->first;
-            if(toggle[curr].exists == 0)
-            {
-                continue;
-            }
-            if(abs(toggle[curr].x - cube[current].x) < 0.26 && abs(toggle[curr].z - cube[current].z) < 0.26)
-            {
-                flag = 1;
-                if(bridge[curr].exists == 0)
-                {
-                    toggle[curr].y -= 0.1;
-                }
-                bridge[curr].exists = 1;
-                stringstream ss;
-                ss << curr;
-                ss << "2";
-                bridge[ss.str()].exists = 1;
-            }
-        }
-        for(map<string, Sprite>::iterator it2 = bridge.begin(); it2 != bridge.end(); it2++)
-        {
-            string curr = it2->first;
-            if(bridge[curr].exists == 0)
-            {
-                continue;
-            }
-            float w = cube[current].width;
-            float d = cube[current].depth;
-            if(bridge[curr].exists == 0)
-            {
-                continue;
-            }
-            if(abs(bridge[curr].x - cube[current].x) <= 0.25 && abs(bridge[curr].z - cube[current].z) <= 0.25)
-            {
-                flag = 1;
-            }
-        }
-        if(flag == 0)
-        {
-            cube["maincube"].y -= 0.03;
-            if(cube["maincube"].y <= -5)
-            {
-                cout << "GAME OVER" << endl;
-                exit(0);
-            }
-        }
-        glm::mat4 MVP; // MVP = Projection * View * Model
-
-        Matrices.model = glm::mat4(1.0f);
-
-        /* Render your scene */
-        glm::mat4 ObjectTransform;
-        glm::mat4 translateObject = glm::translate(glm::vec3(cube[current].x, cube[current].y, cube[current].z));    // glTranslatef
-        glm::mat4 rotateTriangle = glm::rotate((float)((cube[current].anglex) * M_PI / 180.0f), glm::vec3(0, 0, 1)); // rotate about vector (1,0,0)
-        glm::mat4 rotateTriangle1 = glm::rotate((float)((cube[current].angley) * M_PI / 180.0f), glm::vec3(1, 0, 0));
-        glm::mat4 rotateTriangle2 = glm::rotate((float)((cube[current].angle) * M_PI / 180.0f), glm::vec3(0, 1, 0)); // rotate about vector (1,0,0)
-
-        ObjectTransform = translateObject * rotateTriangle * rotateTriangle1 * rotateTriangle2;
-        Matrices.model *= ObjectTransform;
-        MVP = VP * Matrices.model; // MVP = p * V * M
-
-        glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-        draw3DObject(cube[current].object);
+        float alpha = min(1.0, max(0.0, (glfwGetTime() - snapshot.tickTime) / SIM_TICK));
+        blockModel = Matrices.model = blockModelMatrix(block, alpha);
+        submit3DObject(programID, blockSprite->object, Matrices.model, blockSprite->color, LAYER_BLOCK);
     }
 
-    for(map<string, Sprite>::iterator it = tile.begin(); it != tile.end(); it++)
+    for (int i = 0; i < tile.count; i++)
     {
-        string current = it->first;
-        if (tile[current].exists == 0)
+        const Sprite &current = tile.items[i];
+        if (current.exists == 0)
         {
             continue;
         }
-        glm::mat4 MVP; // MVP = Projection * View * Model
-
         Matrices.model = glm::mat4(1.0f);
 
         /* Render your scene */
         glm::mat4 ObjectTransform;
-        glm::mat4 translateObject = glm::translate(glm::vec3(tile[current].x, tile[current].y, tile[current].z)); // glTranslatef
+        glm::mat4 translateObject = glm::translate(glm::vec3(current.x, current.y, current.z)); // glTranslatef
         glm::mat4 rotateTriangle = glm::rotate((float)((0) * M_PI / 180.0f), glm::vec3(0, 1, 0));                 // rotate about vector (1,0,0)
 
         ObjectTransform = translateObject * rotateTriangle;
         Matrices.model *= ObjectTransform;
-        MVP = VP * Matrices.model; // MVP = p * V * M
-
-        glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-
-        draw3DObject(tile[current].object);
+        submit3DObject(programID, current.object, Matrices.model, current.color, LAYER_TILES);
     }
-    for(map<string, Sprite>::iterator it = fragtile.begin(); it != fragtile.end(); it++)
+    // Split screen keeps the CPU chunk path, the cull pass fills its commands for one view a frame
+    bool culledOnGpu = gpuCull.enabled && streamer && views.size() == 1;
+    if (!culledOnGpu)
+        submitStreamedChunks(programID, views);
+    for (int i = 0; i < fragtile.count; i++)
     {
-        string current = it->first;
-        if (fragtile[current].exists == 0)
+        const Sprite &current = fragtile.items[i];
+        if (current.exists == 0)
         {
             continue;
         }
-        glm::mat4 MVP; // MVP = Projection * View * Model
-
         Matrices.model = glm::mat4(1.0f);
 
         /* Render your scene */
         glm::mat4 ObjectTransform;
-        glm::mat4 translateObject = glm::translate(glm::vec3(fragtile[current].x, fragtile[current].y, fragtile[current].z)); // glTranslatef
+        glm::mat4 translateObject = glm::translate(glm::vec3(current.x, current.y, current.z)); // glTranslatef
         glm::mat4 rotateTriangle = glm::rotate((float)((0) * M_PI / 180.0f), glm::vec3(0, 1, 0));                             // rotate about vector (1,0,0)
 
         ObjectTransform = translateObject * rotateTriangle;
         Matrices.model *= ObjectTransform;
-        MVP = VP * Matrices.model; // MVP = p * V * M
-
-        glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-
-        draw3DObject(fragtile[current].object);
+        submit3DObject(programID, current.object, Matrices.model, current.color, LAYER_FRAGILE_TILES);
 
         //glPopMatrix ();
     }
 
-    for(map<string, Sprite>::iterator it = teles.begin(); it != teles.end(); it++)
+    for (int i = 0; i < teles.count; i++)
     {
-        string current = it->first;
-        if (teles[current].exists == 0)
+        const Sprite &current = teles.items[i];
+        if (current.exists == 0)
         {
             continue;
         }
-        glm::mat4 MVP; // MVP = Projection * View * Model
-
         Matrices.model = glm::mat4(1.0f);
 
         /* Render your scene */
         glm::mat4 ObjectTransform;
-        glm::mat4 translateObject = glm::translate(glm::vec3(teles[current].x, teles[current].y, teles[current].z)); // glTranslatef
+        glm::mat4 translateObject = glm::translate(glm::vec3(current.x, current.y, current.z)); // glTranslatef
         glm::mat4 rotateTriangle = glm::rotate((float)((0) * M_PI / 180.0f), glm::vec3(0, 1, 0));                             // rotate about vector (1,0,0)
 
         ObjectTransform = translateObject * rotateTriangle;
         Matrices.model *= ObjectTransform;
-        MVP = VP * Matrices.model; // MVP = p * V * M
-
-        glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-
-        draw3DObject(teles[current].object);
+        submit3DObject(programID, current.object, Matrices.model, current.color, LAYER_TELEPORTERS);
     }
 
-    for(map<string, Sprite>::iterator it = toggle.begin(); it != toggle.end(); it++)
+    for (int i = 0; i < toggle.count; i++)
     {
-        string current = it->first;
-        if (toggle[current].exists == 0)
+        const Sprite &current = toggle.items[i];
+        if (current.exists == 0)
         {
             continue;
         }
-        glm::mat4 MVP; // MVP = Projection * View * Model
-
         Matrices.model = glm::mat4(1.0f);
 
         /* Render your scene */
         glm::mat4 ObjectTransform;
-        glm::mat4 translateObject = glm::translate(glm::vec3(toggle[current].x, toggle[current].y, toggle[current].z)); // glTranslatef
+        glm::mat4 translateObject = glm::translate(glm::vec3(current.x, current.y, current.z)); // glTranslatef
         glm::mat4 rotateTriangle = glm::rotate((float)((0) * M_PI / 180.0f), glm::vec3(0, 1, 0));                       // rotate about vector (1,0,0)
 
         ObjectTransform = translateObject * rotateTriangle;
         Matrices.model *= ObjectTransform;
-        MVP = VP * Matrices.model; // MVP = p * V * M
-
-        glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-
-        draw3DObject(toggle[current].object);
+        submit3DObject(programID, current.object, Matrices.model, current.color, LAYER_SWITCHES);
     }
 
-    for(map<string, Sprite>::iterator it = bridge.begin(); it != bridge.end(); it++)
+    for (int i = 0; i < bridge.count; i++)
     {
-        string current = it->first;
-        if(bridge[current].exists == 0)
+        const Sprite &current = bridge.items[i];
+        if(current.exists == 0)
         {
             continue;
         }
-        glm::mat4 MVP; // MVP = Projection * View * Model
-
         Matrices.model = glm::mat4(1.0f);
 
         /* Render your scene */
         glm::mat4 ObjectTransform;
-        glm::mat4 translateObject = glm::translate(glm::vec3(bridge[current].x, bridge[current].y, bridge[current].z)); // glTranslatef
+        glm::mat4 translateObject = glm::translate(glm::vec3(current.x, current.y, current.z)); // glTranslatef
         glm::mat4 rotateTriangle = glm::rotate((float)((0) * M_PI / 180.0f), glm::vec3(0, 1, 0));                       // rotate about vector (1,0,0)
 
         ObjectTransform = translateObject * rotateTriangle;
         Matrices.model *= ObjectTransform;
-        MVP = VP * Matrices.model; // MVP = p * V * M
-
-        glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-
-        draw3DObject(bridge[current].object);
+        submit3DObject(programID, current.object, Matrices.model, current.color, LAYER_BRIDGES);
     }
-    for(map<string,Sprite>::iterator it=scoredisp.begin(); it!=scoredisp.end(); it++)
-    {
-        string current = it->first;
-        if(scoredisp[current].exists==0)
-        {
-            continue;
-        }
-        glm::mat4 MVP;  // MVP = Projection * View * Model
-
-        Matrices.model = glm::mat4(1.0f);
-
-        /* Render your scene */
-        glm::mat4 ObjectTransform;
-        glm::mat4 translateObject = glm::translate (glm::vec3(scoredisp[current].x, scoredisp[current].y, 0.0f)); // glTranslatef
-        glm::mat4 rotateTriangle = glm::rotate((float)((scoredisp[current].angle)*M_PI/180.0f), glm::vec3(0,0,1));  // rotate about vector (1,0,0)
-
-        ObjectTransform=translateObject*rotateTriangle;
-        Matrices.model *= ObjectTransform;
-        MVP = VP * Matrices.model; // MVP = p * V * M
+    frameStats.sceneCpu = smoothTiming(frameStats.sceneCpu, (glfwGetTime() - scene_start) * 1000);
 
-        glUniformMatrix4fv(Matrices.MatrixID, 1, GL_FALSE, &MVP[0][0]);
-
-        draw3DObject(scoredisp[current].object);
+    // Sort everything submitted this frame once and draw it into every view with minimal state changes
+    // The HUD text goes over every view as the last pass of the frame's GPU timers
+    beginGpuTimerFrame();
+    // The shadow map covers the board, or the cells around the block in a streamed world
+    glm::vec3 shadowCenter(roundf(block.position.x * 2) / 2, BOARD_TOP, roundf(block.position.z * 2) / 2);
+    float shadowRadius = SHADOW_FOLLOW_RADIUS;
+    if (!world.data && board.width > 0)
+    {
+        shadowCenter.x = (board.minx + (board.width - 1) / 2.0f) * 0.5f;
+        shadowCenter.z = (board.minz + (board.depth - 1) / 2.0f) * 0.5f;
+        shadowRadius = 0.25f * sqrtf(board.width * board.width + board.depth * board.depth) + 1;
     }
+    updateShadowMap(blockModel, shadowCenter, shadowRadius, culledOnGpu ? drawGpuCullCasters : NULL);
+    updateLighting(camera.eye);
+    executeRenderQueue(views, culledOnGpu ? drawGpuCulledTiles : NULL);
+    drawHud(fbwidth, fbheight, glfwGetTime(), snapshot.score);
+    endGpuTimerFrame();
+    latencyFrameDrawn(snapshot.tick);
 
     //camera_rotation_angle++; // Simulating camera rotation
     //  triangle_rotation = triangle_rotation + increments*triangle_rot_dir*triangle_rot_status;
     //  rectangle_rotation = rectangle_rotation + increments*rectangle_rot_dir*rectangle_rot_status;
 }
 
-void disp1(int digit)
-{
-  if(digit == 0)
-  {
-    scoredisp["score1.2"].exists = 0;
-
-    scoredisp["score1.1"].exists = 1;
-    scoredisp["score1.3"].exists = 1;
-    scoredisp["score1.4"].exists = 1;
-    scoredisp["score1.5"].exists = 1;
-    scoredisp["score1.6"].exists = 1;
-    scoredisp["score1.7"].exists = 1;
-  }
-  else if(digit == 1)
-  {
-    scoredisp["score1.1"].exists = 0;
-    scoredisp["score1.2"].exists = 0;
-    scoredisp["score1.3"].exists = 0;
-    scoredisp["score1.4"].exists = 0;
-    scoredisp["score1.6"].exists = 0;
-
-    scoredisp["score1.5"].exists = 1;
-    scoredisp["score1.7"].exists = 1;
-  }
-  else if(digit == 2)
-  {
-    scoredisp["score1.4"].exists = 0;
-    scoredisp["score1.7"].exists = 0;
-
-    scoredisp["score1.1"].exists = 1;
-    scoredisp["score1.2"].exists = 1;
-    scoredisp["score1.3"].exists = 1;
-    scoredisp["score1.5"].exists = 1;
-    scoredisp["score1.6"].exists = 1;
-  }
-  else if(digit == 3)
-  {
-    scoredisp["score1.4"].exists = 0;
-    scoredisp["score1.6"].exists = 0;
-
-    scoredisp["score1.1"].exists = 1;
-    scoredisp["score1.2"].exists = 1;
-    scoredisp["score1.3"].exists = 1;
-    scoredisp["score1.5"].exists = 1;
-    scoredisp["score1.7"].exists = 1;
-  }
-  else if(digit == 4)
-  {
-    scoredisp["score1.1"].exists = 0;
-    scoredisp["score1.3"].exists = 0;
-    scoredisp["score1.6"].exists = 0;
-
-    scoredisp["score1.2"].exists = 1;
-    scoredisp["score1.4"].exists = 1;
-    scoredisp["score1.5"].exists = 1;
-    scoredisp["score1.7"].exists = 1;
-  }
-  else if(digit == 5)
-  {
-    scoredisp["score1.5"].exists = 0;
-    scoredisp["score1.6"].exists = 0;
-
-    scoredisp["score1.1"].exists = 1;
-    scoredisp["score1.2"].exists = 1;
-    scoredisp["score1.3"].exists = 1;
-    scoredisp["score1.4"].exists = 1;
-    scoredisp["score1.7"].exists = 1;
-  }
-  else if(digit == 6)
-  {
-    scoredisp["score1.5"].exists = 0;
-
-    scoredisp["score1.1"].exists = 1;
-    scoredisp["score1.2"].exists = 1;
-    scoredisp["score1.3"].exists = 1;
-    scoredisp["score1.4"].exists = 1;
-    scoredisp["score1.6"].exists = 1;
-    scoredisp["score1.7"].exists = 1;
-  }
-  else if(digit == 7)
-  {
-    scoredisp["score1.2"].exists = 0;
-    scoredisp["score1.3"].exists = 0;
-    scoredisp["score1.4"].exists = 0;
-    scoredisp["score1.6"].exists = 0;
-
-    scoredisp["score1.1"].exists = 1;
-    scoredisp["score1.5"].exists = 1;
-    scoredisp["score1.7"].exists = 1;
-  }
-  else if(digit == 8)
-  {
-    scoredisp["score1.1"].exists = 1;
-    scoredisp["score1.2"].exists = 1;
-    scoredisp["score1.3"].exists = 1;
-    scoredisp["score1.4"].exists = 1;
-    scoredisp["score1.5"].exists = 1;
-    scoredisp["score1.6"].exists = 1;
-    scoredisp["score1.7"].exists = 1;
-  }
-  else if(digit == 9)
-  {
-    scoredisp["score1.6"].exists = 0;
-
-    scoredisp["score1.1"].exists = 1;
-    scoredisp["score1.2"].exists = 1;
-    scoredisp["score1.3"].exists = 1;
-    scoredisp["score1.4"].exists = 1;
-    scoredisp["score1.5"].exists = 1;
-    scoredisp["score1.7"].exists = 1;
-  }
-}
-
-void disp10(int digit)
-{
-  if(digit == 0)
-    {
-      scoredisp["score2.2"].exists = 0;
-
-      scoredisp["score2.1"].exists = 1;
-      scoredisp["score2.3"].exists = 1;
-      scoredisp["score2.4"].exists = 1;
-      scoredisp["score2.5"].exists = 1;
-      scoredisp["score2.6"].exists = 1;
-      scoredisp["score2.7"].exists = 1;
-    }
-    else if(digit == 1)
-    {
-      scoredisp["score2.1"].exists = 0;
-      scoredisp["score2.2"].exists = 0;
-      scoredisp["score2.3"].exists = 0;
-      scoredisp["score2.4"].exists = 0;
-      scoredisp["score2.6"].exists = 0;
-
-      scoredisp["score2.5"].exists = 1;
-      scoredisp["score2.7"].exists = 1;
-    }
-    else if(digit == 2)
-    {
-      scoredisp["score2.4"].exists = 0;
-      scoredisp["score2.7"].exists = 0;
-
-      scoredisp["score2.1"].exists = 1;
-      scoredisp["score2.2"].exists = 1;
-      scoredisp["score2.3"].exists = 1;
-      scoredisp["score2.5"].exists = 1;
-      scoredisp["score2.6"].exists = 1;
-    }
-    else if(digit == 3)
-    {
-      scoredisp["score2.4"].exists = 0;
-      scoredisp["score2.6"].exists = 0;
-
-      scoredisp["score2.1"].exists = 1;
-      scoredisp["score2.2"].exists = 1;
-      scoredisp["score2.3"].exists = 1;
-      scoredisp["score2.5"].exists = 1;
-      scoredisp["score2.7"].exists = 1;
-    }
-    else if(digit == 4)
-    {
-      scoredisp["score2.1"].exists = 0;
-      scoredisp["score2.3"].exists = 0;
-      scoredisp["score2.6"].exists = 0;
-
-      scoredisp["score2.2"].exists = 1;
-      scoredisp["score2.4"].exists = 1;
-      scoredisp["score2.5"].exists = 1;
-      scoredisp["score2.7"].exists = 1;
-    }
-    else if(digit == 5)
-    {
-      scoredisp["score2.5"].exists = 0;
-      scoredisp["score2.6"].exists = 0;
-
-      scoredisp["score2.1"].exists = 1;
-      scoredisp["score2.2"].exists = 1;
-      scoredisp["score2.3"].exists = 1;
-      scoredisp["score2.4"].exists = 1;
-      scoredisp["score2.7"].exists = 1;
-    }
-    else if(digit == 6)
-    {
-      scoredisp["score2.5"].exists = 0;
-
-      scoredisp["score2.1"].exists = 1;
-      scoredisp["score2.2"].exists = 1;
-      scoredisp["score2.3"].exists = 1;
-      scoredisp["score2.4"].exists = 1;
-      scoredisp["score2.6"].exists = 1;
-      scoredisp["score2.7"].exists = 1;
-    }
-    else if(digit == 7)
-    {
-      scoredisp["score2.2"].exists = 0;
-      scoredisp["score2.3"].exists = 0;
-      scoredisp["score2.4"].exists = 0;
-      scoredisp["score2.6"].exists = 0;
-
-      scoredisp["score2.1"].exists = 1;
-      scoredisp["score2.5"].exists = 1;
-      scoredisp["score2.7"].exists = 1;
-    }
-    else if(digit == 8)
-    {
-      scoredisp["score2.1"].exists = 1;
-      scoredisp["score2.2"].exists = 1;
-      scoredisp["score2.3"].exists = 1;
-      scoredisp["score2.4"].exists = 1;
-      scoredisp["score2.5"].exists = 1;
-      scoredisp["score2.6"].exists = 1;
-      scoredisp["score2.7"].exists = 1;
-    }
-    else if(digit == 9)
-    {
-      scoredisp["score2.6"].exists = 0;
-
-      scoredisp["score2.1"].exists = 1;
-      scoredisp["score2.2"].exists = 1;
-      scoredisp["score2.3"].exists = 1;
-      scoredisp["score2.4"].exists = 1;
-      scoredisp["score2.5"].exists = 1;
-      scoredisp["score2.7"].exists = 1;
-    }
-}
-
-void disp100(int digit)
-{
-  if(digit == 0)
-    {
-      scoredisp["score3.2"].exists = 0;
-
-      scoredisp["score3.1"].exists = 1;
-      scoredisp["score3.3"].exists = 1;
-      scoredisp["score3.4"].exists = 1;
-      scoredisp["score3.5"].exists = 1;
-      scoredisp["score3.6"].exists = 1;
-      scoredisp["score3.7"].exists = 1;
-    }
-    else if(digit == 1)
-    {
-      scoredisp["score3.1"].exists = 0;
-      scoredisp["score3.2"].exists = 0;
-      scoredisp["score3.3"].exists = 0;
-      scoredisp["score3.4"].exists = 0;
-      scoredisp["score3.6"].exists = 0;
-
-      scoredisp["score3.5"].exists = 1;
-      scoredisp["score3.7"].exists = 1;
-    }
-    else if(digit == 2)
-    {
-      scoredisp["score3.4"].exists = 0;
-      scoredisp["score3.7"].exists = 0;
-
-      scoredisp["score3.1"].exists = 1;
-      scoredisp["score3.2"].exists = 1;
-      scoredisp["score3.3"].exists = 1;
-      scoredisp["score3.5"].exists = 1;
-      scoredisp["score3.6"].exists = 1;
-    }
-    else if(digit == 3)
-    {
-      scoredisp["score3.4"].exists = 0;
-      scoredisp["score3.6"].exists = 0;
-
-      scoredisp["score3.1"].exists = 1;
-      scoredisp["score3.2"].exists = 1;
-      scoredisp["score3.3"].exists = 1;
-      scoredisp["score3.5"].exists = 1;
-      scoredisp["score3.7"].exists = 1;
-    }
-    else if(digit == 4)
-    {
-      scoredisp["score3.1"].exists = 0;
-      scoredisp["score3.3"].exists = 0;
-      scoredisp["score3.6"].exists = 0;
-
-      scoredisp["score3.2"].exists = 1;
-      scoredisp["score3.4"].exists = 1;
-      scoredisp["score3.5"].exists = 1;
-      scoredisp["score3.7"].exists = 1;
-    }
-    else if(digit == 5)
-    {
-      scoredisp["score3.5"].exists = 0;
-      scoredisp["score3.6"].exists = 0;
-
-      scoredisp["score3.1"].exists = 1;
-      scoredisp["score3.2"].exists = 1;
-      scoredisp["score3.3"].exists = 1;
-      scoredisp["score3.4"].exists = 1;
-      scoredisp["score3.7"].exists = 1;
-    }
-    else if(digit == 6)
-    {
-      scoredisp["score3.5"].exists = 0;
-
-      scoredisp["score3.1"].exists = 1;
-      scoredisp["score3.2"].exists = 1;
-      scoredisp["score3.3"].exists = 1;
-      scoredisp["score3.4"].exists = 1;
-      scoredisp["score3.6"].exists = 1;
-      scoredisp["score3.7"].exists = 1;
-    }
-    else if(digit == 7)
-    {
-      scoredisp["score3.2"].exists = 0;
-      scoredisp["score3.3"].exists = 0;
-      scoredisp["score3.4"].exists = 0;
-      scoredisp["score3.6"].exists = 0;
-
-      scoredisp["score3.1"].exists = 1;
-      scoredisp["score3.5"].exists = 1;
-      scoredisp["score3.7"].exists = 1;
-    }
-    else if(digit == 8)
-    {
-      scoredisp["score3.1"].exists = 1;
-      scoredisp["score3.2"].exists = 1;
-      scoredisp["score3.3"].exists = 1;
-      scoredisp["score3.4"].exists = 1;
-      scoredisp["score3.5"].exists = 1;
-      scoredisp["score3.6"].exists = 1;
-      scoredisp["score3.7"].exists = 1;
-    }
-    else if(digit == 9)
-    {
-      scoredisp["score3.6"].exists = 0;
-
-      scoredisp["score3.1"].exists = 1;
-      scoredisp["score3.2"].exists = 1;
-      scoredisp["score3.3"].exists = 1;
-      scoredisp["score3.4"].exists = 1;
-      scoredisp["score3.5"].exists = 1;
-      scoredisp["score3.7"].exists = 1;
-    }
-}
-
-void Dispscore()
-{
-  int temp = score;
-  if(temp < 0)
-  {
-    exit(0);
-  }
-  if(temp <= 999)
-  {
-    scoredisp["sign"].exists = 0;
-    disp1(temp % 10);
-    temp /= 10;
-    disp10(temp % 10);
-    temp /= 10;
-    disp100(temp % 10);
-  }
-  else
-  {
-    scoredisp["sign"].exists = 0;
-    disp1(9);
-    disp10(9);
-    disp100(9);
-  }
-}
-
 /* Initialise glfw window, I/O callbacks and the renderer to use */
 /* Nothing to Edit here */
 GLFWwindow* initGLFW (int width, int height)
@@ -1740,10 +430,13 @@ GLFWwindow* initGLFW (int width, int height)
     {
         exit(EXIT_FAILURE);
     }
+    // Drivers give the highest core version they support for a 3.3 request, --gpu-cull checks for 4.3 once loaded
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    if (headless)
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
 
     window = glfwCreateWindow(width, height, "Sample OpenGL 3.3 Application", NULL, NULL);
 
@@ -1754,9 +447,13 @@ GLFWwindow* initGLFW (int width, int height)
     }
     glfwMakeContextCurrent(window);
     gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
-    glfwSwapInterval(1);
+    // Headless runs measure how fast frames can be made unless a pacing mode is asked for
+    if (headless && !pacing.chosen)
+        pacing.mode = PACING_UNCAPPED;
+    startFramePacing();
     glfwSetFramebufferSizeCallback(window, reshapeWindow);
-    glfwSetWindowSizeCallback(window, reshapeWindow);
+    glfwSetWindowSizeCallback(window, windowResized);
+    glfwSetCursorPosCallback(window, cursorMoved);
     glfwSetWindowCloseCallback(window, quit);
     glfwSetKeyCallback(window, keyboard);            // general keyboard input
     glfwSetCharCallback(window, keyboardChar);       // simpler specific character handling
@@ -1772,95 +469,71 @@ void initGL(GLFWwindow *window, int width, int height)
     /* Objects should be created before any other gl function and shaders */
     // Create the models
     // createTriangle (); // Generate the VAO, VBOs, vertices data & copy into the array buffer
-    createRectangle("maincube", -3.5, -0.15, 0, 0.5, 1, 0.5, "cube", 0, green);
-    //right part
-    createRectangle("t(3,0)", 3, -0.7, 0, 0.5, 0.1, 0.5, "tile", 0, yellow);
-    createRectangle("t(1,-0.5)", 1, -0.7, -0.5, 0.5, 0.1, 0.5, "tile", 0, black);
-    createRectangle("t(1,-1)", 1, -0.7, -1, 0.5, 0.1, 0.5, "tile", 0, yellow);
-    createRectangle("t(1,1)", 1, -0.7, 1, 0.5, 0.1, 0.5, "tile", 0, yellow);
-    createRectangle("t(3.5,0)", 3.5, -0.7, 0, 0.5, 0.1, 0.5, "tile", 0, black);
-    createRectangle("t(3.5,-0.5)", 3.5, -0.7, -0.5, 0.5, 0.1, 0.5, "tile", 0, yellow);
-    createRectangle("t(3.5,0.5)", 3.5, -0.7, 0.5, 0.5, 0.1, 0.5, "tile", 0, yellow);
-
-    createRectangle("t(3,0.5)", 3, -0.7, 0.5, 0.5, 0.1, 0.5, "tile", 0, black);
-    createRectangle("t(3,1)", 3, -0.7, 1, 0.5, 0.1, 0.5, "tile", 0, yellow);
-    createRectangle("t(3,-0.5)", 3, -0.7, -0.5, 0.5, 0.1, 0.5, "tile", 0, black);
-    createRectangle("t(3,-1)", 3, -0.7, -1, 0.5, 0.1, 0.5, "tile", 0, yellow);
-    createRectangle("t(2,0.5)", 2, -0.7, 0.5, 0.5, 0.1, 0.5, "tile", 0, black);
-    createRectangle("t(1.5,0)", 1.5, -0.7, 0, 0.5, 0.1, 0.5, "tile", 0, black);
-    createRectangle("t(2.5,0.5)", 2.5, -0.7, 0.5, 0.5, 0.1, 0.5, "tile", 0, yellow);
-    createRectangle("t(2.5,1)", 2.5, -0.7, 1, 0.5, 0.1, 0.5, "tile", 0, black);
-    createRectangle("t(1.5,0.5)", 1.5, -0.7, 0.5, 0.5, 0.1, 0.5, "tile", 0, yellow);
-    createRectangle("t(2.5,-0.5)", 2.5, -0.7, -0.5, 0.5, 0.1, 0.5, "tile", 0, yellow);
-    createRectangle("t(2.5,-1)", 2.5, -0.7, -1, 0.5, 0.1, 0.5, "tile", 0, black);
-    createRectangle("t(1.5,-0.5)", 1.5, -0.7, -0.5, 0.5, 0.1, 0.5, "tile", 0, yellow);
-    createRectangle("t(1.5,-1)", 1.5, -0.7, -1, 0.5, 0.1, 0.5, "tile", 0, black);
-    createRectangle("t(1.5,1)", 1.5, -0.7, 1, 0.5, 0.1, 0.5, "tile", 0, black);
-    createRectangle("t(2,-0.5)", 2, -0.7, -0.5, 0.5, 0.1, 0.5, "tile", 0, black);
-    createRectangle("t(1,0)", 1, -0.7, 0, 0.5, 0.1, 0.5, "tile", 0, yellow);
-    createRectangle("t(2,1)", 2, -0.7, 1, 0.5, 0.1, 0.5, "tile", 0, yellow);
-    createRectangle("t(2,1.5)", 2, -0.7, 1.5, 0.5, 0.1, 0.5, "tile", 0, black);
-    createRectangle("t(2,-1)", 2, -0.7, -1, 0.5, 0.1, 0.5, "tile", 0, yellow);
-    createRectangle("t(2,-1.5)", 2, -0.7, -1.5, 0.5, 0.1, 0.5, "tile", 0, black);
-    //left part
-    createRectangle("t(-1.5,0)", -1.5, -0.7, 0, 0.5, 0.1, 0.5, "tile", 0, black);
-    createRectangle("t(-1,0)", -1, -0.7, 0, 0.5, 0.1, 0.5, "tile", 0, yellow);
-    createRectangle("t(-0.5,0)", -0.5, -0.7, 0, 0.5, 0.1, 0.5, "tile", 0, black);
-    createRectangle("t(-1,0.5)", -1, -0.7, 0.5, 0.5, 0.1, 0.5, "tile", 0, black);
-    createRectangle("t(-1,-0.5)", -1, -0.7, -0.5, 0.5, 0.1, 0.5, "tile", 0, black);
-    createRectangle("t(-2,0.5)", -2, -0.7, 0.5, 0.5, 0.1, 0.5, "tile", 0, black);
-    createRectangle("t(-2.5,0)", -2.5, -0.7, 0, 0.5, 0.1, 0.5, "tile", 0, black);
-    createRectangle("t(-2.5,0.5)", -2.5, -0.7, 0.5, 0.5, 0.1, 0.5, "tile", 0, yellow);
-    createRectangle("t(-1.5,-0.5)", -1.5, -0.7, -0.5, 0.5, 0.1, 0.5, "tile", 0, yellow);
-    createRectangle("t(-2.5,-0.5)", -2.5, -0.7, -0.5, 0.5, 0.1, 0.5, "tile", 0, yellow);
-    createRectangle("t(-2,-0.5)", -2, -0.7, -0.5, 0.5, 0.1, 0.5, "tile", 0, black);
-    createRectangle("t(-3,0)", -3, -0.7, 0, 0.5, 0.1, 0.5, "tile", 0, yellow);
-    createRectangle("t(-2,1)", -2, -0.7, 1, 0.5, 0.1, 0.5, "tile", 0, yellow);
-    createRectangle("t(-2,-1)", -2, -0.7, -1, 0.5, 0.1, 0.5, "tile", 0, yellow);
-    createRectangle("t(-2,0)", -2, -0.7, 0, 0.5, 0.1, 0.5, "tile", 0, yellow);
-    createRectangle("t(-3.5,0)", -3.5, -0.7, 0, 0.5, 0.1, 0.5, "tile", 0, black);
-    createRectangle("goal", 2, -0.7, 0, 0.5, 0.1, 0.5, "tile", 0, bg);
-    //bridge and switch pairs
-    createRectangle("s1", -1.5, -0.7, -0.5, 0.4, 0.4, 0.4, "toggle", 0, grey);
-    createRectangle("s1", 0, -0.7, 0, 0.5, 0.1, 0.5, "bridge", 0, red);
-    createRectangle("s12", 0.5, -0.7, 0, 0.5, 0.1, 0.5, "bridge", 0, red);
-    //fragmented tiles
-    createRectangle("t(-1.5,0.5)", 0.5 + -2, -0.7, 0.5, 0.5, 0.1, 0.5, "fragtile", 0, teal);
-    createRectangle("t(1,0.5)", 1, -0.7, 0.5, 0.5, 0.1, 0.5, "fragtile", 0, teal);
-    createRectangle("t(2.5,0)", 0.5 + 2, -0.7, 0, 0.5, 0.1, 0.5, "fragtile", 0, teal);
-    // scoreboard
-    createRectangle("sign", 0.7, 3.3, 0, 0.2, 0.05, 0.05, "scoredisp", 0, steel);
-
-    createRectangle("score1.1", 1, 3.5, 0, 0.2, 0.05, 0.05, "scoredisp", 0, steel);
-    createRectangle("score1.2", 1, 3.3, 0, 0.2, 0.05, 0.05, "scoredisp", 0, steel);
-    createRectangle("score1.3", 1, 3.1, 0, 0.2, 0.05, 0.05, "scoredisp", 0, steel);
-    createRectangle("score1.4", 0.9, 3.4, 0, 0.05, 0.2, 0.05, "scoredisp", 0, steel);
-    createRectangle("score1.5", 1.1, 3.4, 0, 0.05, 0.2, 0.05, "scoredisp", 0, steel);
-    createRectangle("score1.6", 0.9, 3.2, 0, 0.05, 0.2, 0.05, "scoredisp", 0, steel);
-    createRectangle("score1.7", 1.1, 3.2, 0, 0.05, 0.2, 0.05, "scoredisp", 0, steel);
-
-    createRectangle("score2.1", 0.7, 3.5, 0, 0.2, 0.05, 0.05, "scoredisp", 0, steel);
-    createRectangle("score2.2", 0.7, 3.3, 0, 0.2, 0.05, 0.05, "scoredisp", 0, steel);
-    createRectangle("score2.3", 0.7, 3.1, 0, 0.2, 0.05, 0.05, "scoredisp", 0, steel);
-    createRectangle("score2.4", 0.6, 3.4, 0, 0.05, 0.2, 0.05, "scoredisp", 0, steel);
-    createRectangle("score2.5", 0.8, 3.4, 0, 0.05, 0.2, 0.05, "scoredisp", 0, steel);
-    createRectangle("score2.6", 0.6, 3.2, 0, 0.05, 0.2, 0.05, "scoredisp", 0, steel);
-    createRectangle("score2.7", 0.8, 3.2, 0, 0.05, 0.2, 0.05, "scoredisp", 0, steel);
-
-    createRectangle("score3.1", 0.4, 3.5, 0, 0.2, 0.05, 0.05, "scoredisp", 0, steel);
-    createRectangle("score3.2", 0.4, 3.3, 0, 0.2, 0.05, 0.05, "scoredisp", 0, steel);
-    createRectangle("score3.3", 0.4, 3.1, 0, 0.2, 0.05, 0.05, "scoredisp", 0, steel);
-    createRectangle("score3.4", 0.3, 3.4, 0, 0.05, 0.2, 0.05, "scoredisp", 0, steel);
-    createRectangle("score3.5", 0.5, 3.4, 0, 0.05, 0.2, 0.05, "scoredisp", 0, steel);
-    createRectangle("score3.6", 0.3, 3.2, 0, 0.05, 0.2, 0.05, "scoredisp", 0, steel);
-    createRectangle("score3.7", 0.5, 3.2, 0, 0.05, 0.2, 0.05, "scoredisp", 0, steel);
+    createRectangle("maincube", -3.5, -0.15, 0, 0.5, 1, 0.5, "cube", 0, coolblue);
+    // The simulation waits on level loads and asks for the next level through its hooks
+    simulationHooks.levelLoading = levelLoading;
+    simulationHooks.nextLevel = startnextlevel;
+    // tiles, switches and bridges of the first level
+    loadLevel(levelPath(levelstate));
+
+    if (world.data)
+    {
+        // The streamed world replaces the built in level, followed by the camera as it is too large to frame
+        clearSprites(tile);
+        clearSprites(fragtile);
+        clearSprites(toggle);
+        clearSprites(bridge);
+        placeBlock(world.header.startX, world.header.startZ);
+        setCameraMode(CAMERA_FOLLOW);
+        startStreaming();
+    }
+
+    // The light every lit program reads from its Lighting block, and the shadow map it casts
+    initLighting();
+    initShadowMap();
 
     // Create and compile our GLSL program from the shaders
     programID = LoadShaders("Sample_GL.vert", "Sample_GL.frag");
+    bindLightingBlock(programID);
     // Get a handle for our "MVP" uniform
     Matrices.MatrixID = glGetUniformLocation(programID, "MVP");
+    // Model matrix, used to bring normals to world space for lighting
+    Matrices.ModelID = glGetUniformLocation(programID, "M");
+    registerProgram(programID);
+
+    // Distant streamed chunks are drawn as textured quads
+    impostorProgramID = LoadShaders("Sample_GL_impostor.vert", NULL, "Sample_GL_impostor.frag");
+    if (impostorProgramID)
+    {
+        registerProgram(impostorProgramID);
+        bindLightingBlock(impostorProgramID);
+        glUseProgram(impostorProgramID);
+        glUniform1i(glGetUniformLocation(impostorProgramID, "impostor"), 0);
+    }
+
+    // Viewport arrays (GL 4.1) let split screen render every view in a single pass
+    multiView.programID = 0;
+    if (GLAD_GL_VERSION_4_1)
+        multiView.programID = LoadShaders("Sample_GL_multiview.vert", "Sample_GL_multiview.geom", "Sample_GL.frag");
+    multiView.source = programID;
+    if (multiView.programID)
+    {
+        bindLightingBlock(multiView.programID);
+        multiView.ModelID = glGetUniformLocation(multiView.programID, "M");
+        multiView.VPID = glGetUniformLocation(multiView.programID, "VP");
+        multiView.ViewCountID = glGetUniformLocation(multiView.programID, "viewCount");
+    }
 
-    reshapeWindow(window, width, height);
+    // Starting metrics, the callbacks keep them up to date from here on
+    glfwGetWindowSize(window, &windowMetrics.width, &windowMetrics.height);
+    glfwGetCursorPos(window, &windowMetrics.cursorX, &windowMetrics.cursorY);
+    int fbwidth, fbheight;
+    glfwGetFramebufferSize(window, &fbwidth, &fbheight);
+    reshapeWindow(window, fbwidth, fbheight);
+    initGpuTimers();
+    initGpuCull();
+    initText();
+    initRollTable();
 
     // Background color of the scene
     glClearColor(50 / 255.0,  14 / 255.0, 59 / 255.0, 0.0f); // R, G, B, A
@@ -1875,82 +548,131 @@ int main(int argc, char **argv)
     int width = 600;
     int height = 600;
     proj_type = 1;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--replay") && i + 1 < argc)
+        {
+            loadReplay(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--lod") && i + 2 < argc)
+        {
+            lodTopPixels = atof(argv[++i]);
+            lodImpostorPixels = atof(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--headless"))
+        {
+            headless = 1;
+        }
+        else if (!strcmp(argv[i], "--latency"))
+        {
+            replayPaced = true;
+        }
+        else if (!strcmp(argv[i], "--pacing") && i + 1 < argc)
+        {
+            if (!parsePacingMode(argv[++i]))
+                exit(1);
+        }
+        else if (!strcmp(argv[i], "--shadow-size") && i + 1 < argc)
+        {
+            shadow.size = atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--shadow-update") && i + 1 < argc)
+        {
+            if (!parseShadowUpdate(argv[++i]))
+                exit(1);
+        }
+        else if (!strcmp(argv[i], "--gpu-cull"))
+        {
+            gpuCullRequested = 1;
+        }
+        else if (!strcmp(argv[i], "--world") && i + 1 < argc)
+        {
+            if (!openWorld(argv[++i]))
+                exit(1);
+        }
+        else if (!strcmp(argv[i], "--make-world") && i + 3 < argc)
+        {
+            const char *path = argv[++i];
+            int chunksX = atoi(argv[++i]);
+            int chunksZ = atoi(argv[++i]);
+            exit(writeProceduralWorld(path, chunksX, chunksZ) ? 0 : 1);
+        }
+    }
     GLFWwindow *window = initGLFW(width, height);
+    startUploadThread(window);
     initGL(window, width, height);
     double last_update_time = glfwGetTime(), current_time;
-    mpg123_handle *mh;
-    unsigned char *buffer;
-    size_t buffer_size;
-    size_t done;
-    int err;
-
-    int driver;
-    ao_device *dev;
-
-    ao_sample_format format;
-    int channels, encoding;
-    long rate;
-
-    /* initializations */
-    ao_initialize();
-    driver = ao_default_driver_id();
-    mpg123_init();
-    mh = mpg123_new(NULL, &err);
-    buffer_size = 3000;
-    buffer = (unsigned char *)malloc(buffer_size * sizeof(unsigned char));
-
-    /* open the file and get the decoding format */
-    mpg123_open(mh, "arcade.mp3");
-    mpg123_getformat(mh, &rate, &channels, &encoding);
-
-    /* set the output format and open the output device */
-    format.bits = mpg123_encsize(encoding) * BITS;
-    format.rate = rate;
-    format.channels = channels;
-    format.byte_format = AO_FMT_NATIVE;
-    format.matrix = 0;
-    dev = ao_open_live(driver, &format, NULL);
-
-    scoredisp["score1.2"].exists = 0;
-    scoredisp["score2.2"].exists = 0;
-    scoredisp["score3.2"].exists = 0;
+    string window_title;
+    if (!headless)
+        startMusic("arcade.mp3");
+    else
+    {
+        headlessStart = glfwGetTime();
+        atexit(printHeadlessSummary);
+    }
+    startSimulationThread();
 
     /* Draw in loop */
+    int exitCode = EXIT_SUCCESS;
     while (!glfwWindowShouldClose(window))
     {
-        /* decode and play */
-        if (mpg123_read(mh, buffer, buffer_size, &done) == MPG123_OK)
-        {
-            ao_play(dev, (char *)buffer, done);
-        }
-        else
+        // The newest state the simulation thread has published, the game ends once it says so
+        const SimSnapshot &snapshot = acquireSnapshot();
+        if (snapshot.exitCode >= 0)
         {
-            mpg123_seek(mh, 0, SEEK_SET);
+            exitCode = snapshot.exitCode;
+            break;
         }
-        // OpenGL Draw commands
+        if (applySnapshot(snapshot))
+            markShadowDirty();
 
+        // The title only goes to the window system when it changes, once a second or per move
         string str2 = to_string((int)last_update_time);
-        string str3 = to_string(score);
+        string str3 = to_string(snapshot.score);
         string title_string = " TIME: " + str2 + " Moves: " + str3;
-        const char *message = title_string.c_str();
-        glfwSetWindowTitle(window, message);
+        if (title_string != window_title)
+        {
+            glfwSetWindowTitle(window, title_string.c_str());
+            window_title = title_string;
+        }
+
+        double frame_start = glfwGetTime();
+
+        // A replay has played out once the simulation took every move and the block came to rest
+        // The replay is fed from here so the main thread stays the only producer of the input queue
+        bool inputDrained = snapshot.inputTaken == inputPushed();
+        if (headless && replayFed() && inputDrained && snapshot.idle)
+        {
+            glfwSetWindowShouldClose(window, 1);
+        }
+        feedReplay();
+        updateStreaming(snapshot.block);
+        updateLevelLoad(LEVEL_UPLOAD_BUDGET);
+        frameStats.simCpu = smoothTiming(frameStats.simCpu, snapshot.simCpu);
 
         // clear the color and depth in the frame buffer
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // OpenGL Draw commands
-        draw(window, 0, 0, 1, 1);
-        // proj_type ^= 1;
-        // draw(window, 0.5, 0, 0.5, 1);
-        // proj_type ^= 1;
-
-        Dispscore();
+        draw(window, snapshot);
+        double frame_cpu = (glfwGetTime() - frame_start) * 1000;
+        frameStats.frameCpu = smoothTiming(frameStats.frameCpu, frame_cpu);
+        frameStats.frameCpuPeak = max(frameStats.frameCpuPeak, frame_cpu);
 
         // Swap Frame Buffer in double buffering
         glfwSwapBuffers(window);
+        latencyFrameSwapped();
+        paceFrame();
+        headlessFrames++;
+        headlessEnd = glfwGetTime();
 
         // Poll for Keyboard and mouse events
         glfwPollEvents();
+        // A paced replay presses its next key here, where the key callbacks run, once the block rests
+        if (replayPaced && inputDrained && snapshot.idle)
+        {
+            feedReplayMove();
+        }
 
         // Control based on time (Time based transformation like 5 degrees rotation every 0.5s)
         current_time = glfwGetTime(); // Time in seconds
@@ -1960,14 +682,12 @@ int main(int argc, char **argv)
         }
     }
 
-    /* clean up */
-    free(buffer);
-    ao_close(dev);
-    mpg123_close(mh);
-    mpg123_delete(mh);
-    mpg123_exit();
-    ao_shutdown();
-
+    // The summary is printed after the context is gone, read back what it needs from the GPU now
+    if (headless)
+        readGpuCullStats();
+    stopMusic();
+    stopSimulationThread();
+    stopUploadThread();
     glfwTerminate();
-    //    exit(EXIT_SUCCESS);
+    return exitCode;
 }
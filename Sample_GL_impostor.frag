@@ -0,0 +1,29 @@
+#version 330 core
+
+in vec2 fragTexCoord;
+in vec3 fragNormal;
+
+// One texel per cell, alpha 0 where the chunk has no tile
+uniform sampler2D impostor;
+
+out vec3 color;
+
+// Same light as Sample_GL.frag, distant chunks skip the highlight and the shadows
+layout (std140) uniform Lighting
+{
+    vec4 lightDirection;
+    vec4 lightColor;
+    vec4 ambient;
+    vec4 eye;
+    vec4 specular;
+};
+
+void main()
+{
+    vec4 texel = texture(impostor, fragTexCoord);
+    if (texel.a < 0.5)
+        discard;
+
+    float diffuse = max(dot(normalize(fragNormal), lightDirection.xyz), 0.0);
+    color = texel.rgb * (ambient.rgb + lightColor.rgb * diffuse);
+}
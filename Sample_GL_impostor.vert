@@ -0,0 +1,22 @@
+#version 330 core
+
+// Impostor quad of a streamed chunk, positions are relative to the chunk corner
+layout (location = 0) in vec3 vertexPosition;
+layout (location = 2) in vec3 vertexNormal;
+
+uniform mat4 MVP;
+uniform mat4 M;
+
+// Cells are 0.5 apart and centered on multiples of 0.5, a chunk is 16 cells wide
+const float cellSize = 0.5;
+const float chunkCells = 16.0;
+
+out vec2 fragTexCoord;
+out vec3 fragNormal;
+
+void main ()
+{
+    fragTexCoord = (vertexPosition.xz + 0.5 * cellSize) / (cellSize * chunkCells);
+    fragNormal = mat3(M) * vertexNormal;
+    gl_Position = MVP * vec4(vertexPosition, 1);
+}
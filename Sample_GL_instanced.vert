@@ -0,0 +1,22 @@
+#version 330 core
+
+// Tile mesh around the origin, moved into place and colored per instance by the GPU cull pass
+layout (location = 0) in vec3 vertexPosition;
+layout (location = 2) in vec3 vertexNormal;
+layout (location = 3) in vec4 instancePosition;
+layout (location = 4) in vec4 instanceColor;
+
+uniform mat4 MVP;
+uniform mat4 M;
+
+out vec3 fragColor;
+out vec3 fragNormal;
+out vec3 fragPosition;
+
+void main ()
+{
+    fragColor = instanceColor.rgb;
+    fragNormal = mat3(M) * vertexNormal;
+    fragPosition = vec3(M * vec4(vertexPosition + instancePosition.xyz, 1));
+    gl_Position = MVP * vec4(vertexPosition + instancePosition.xyz, 1);
+}
@@ -0,0 +1,20 @@
+#version 330 core
+
+// input data : sent from main program
+layout (location = 0) in vec3 vertexPosition;
+layout (location = 1) in vec3 vertexColor; // per vertex for merged meshes, otherwise set per draw
+layout (location = 2) in vec3 vertexNormal;
+
+uniform mat4 M;
+
+// output data : used by the geometry shader, which applies the per view VP
+out vec4 worldPosition;
+out vec3 geomColor;
+out vec3 geomNormal;
+
+void main ()
+{
+    worldPosition = M * vec4(vertexPosition, 1);
+    geomColor = vertexColor;
+    geomNormal = mat3(M) * vertexNormal;
+}
@@ -0,0 +1,6 @@
+#version 330 core
+
+// No color attachment, the depth is written by the fixed function
+void main()
+{
+}
@@ -0,0 +1,11 @@
+#version 330 core
+
+// Shadow casters drawn from the light, only their depth is kept
+layout (location = 0) in vec3 vertexPosition;
+
+uniform mat4 MVP;
+
+void main ()
+{
+    gl_Position = MVP * vec4(vertexPosition, 1);
+}
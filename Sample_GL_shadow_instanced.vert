@@ -0,0 +1,12 @@
+#version 330 core
+
+// Tile instances drawn from the light for the GPU cull path, only their depth is kept
+layout (location = 0) in vec3 vertexPosition;
+layout (location = 3) in vec4 instancePosition;
+
+uniform mat4 MVP;
+
+void main ()
+{
+    gl_Position = MVP * vec4(vertexPosition + instancePosition.xyz, 1);
+}
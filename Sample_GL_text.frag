@@ -0,0 +1,25 @@
+#version 330 core
+
+in vec2 fragTexCoord;
+in vec4 fragColor;
+
+// Signed distance field of the glyphs, 0.5 on the outline
+uniform sampler2D atlas;
+
+out vec4 color;
+
+// Dark border around the glyphs so the HUD reads over any part of the scene
+const float border = 0.35;
+const vec3 borderColor = vec3(0.05, 0.02, 0.08);
+
+void main()
+{
+    float distance = texture(atlas, fragTexCoord).r;
+    // Antialias over one screen pixel whatever size the text is drawn at
+    float width = fwidth(distance) * 0.75;
+    float fill = smoothstep(0.5 - width, 0.5 + width, distance);
+    float outline = smoothstep(border - width, border + width, distance);
+    if (outline == 0.0)
+        discard;
+    color = vec4(mix(borderColor, fragColor.rgb, fill), fragColor.a * outline);
+}
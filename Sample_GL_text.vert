@@ -0,0 +1,19 @@
+#version 330 core
+
+// Glyph quads in framebuffer pixels, origin at the top left
+layout (location = 0) in vec2 vertexPosition;
+layout (location = 1) in vec2 vertexTexCoord;
+layout (location = 2) in vec4 vertexColor;
+
+uniform vec2 screenSize;
+
+out vec2 fragTexCoord;
+out vec4 fragColor;
+
+void main ()
+{
+    fragTexCoord = vertexTexCoord;
+    fragColor = vertexColor;
+    vec2 ndc = vertexPosition / screenSize * 2.0 - 1.0;
+    gl_Position = vec4(ndc.x, -ndc.y, 0, 1);
+}
@@ -0,0 +1,89 @@
+#include "audio/music.h"
+#include <ao/ao.h>
+#include <mpg123.h>
+#define BITS 8
+
+struct Music
+{
+    mpg123_handle *mh;
+    unsigned char *buffer;
+    size_t buffer_size;
+    ao_device *dev; // NULL when no audio device could be opened
+    thread *player; // decodes and plays until quit is set, NULL without a device
+    atomic<int> quit;
+} music;
+
+/* Decode and play one buffer after the other, back to the start at the end of the file
+ * ao_play blocks until the device takes the buffer, so the device paces this thread and not the frames */
+void musicWorker()
+{
+    size_t done;
+    while (!music.quit.load(memory_order_relaxed))
+    {
+        if (mpg123_read(music.mh, music.buffer, music.buffer_size, &done) == MPG123_OK)
+        {
+            ao_play(music.dev, (char *)music.buffer, done);
+        }
+        else if (mpg123_seek(music.mh, 0, SEEK_SET) < 0)
+        {
+            return; // nothing to decode, the game goes on silently
+        }
+    }
+}
+
+/* Open path and the default audio device, the game plays on silently if there is none */
+void startMusic(const char *path)
+{
+    int err;
+    int driver;
+    ao_sample_format format;
+    int channels, encoding;
+    long rate;
+
+    /* initializations */
+    ao_initialize();
+    driver = ao_default_driver_id();
+    mpg123_init();
+    music.mh = mpg123_new(NULL, &err);
+    music.buffer_size = 3000;
+    music.buffer = (unsigned char *)malloc(music.buffer_size * sizeof(unsigned char));
+
+    /* open the file and get the decoding format */
+    mpg123_open(music.mh, path);
+    mpg123_getformat(music.mh, &rate, &channels, &encoding);
+
+    /* set the output format and open the output device */
+    format.bits = mpg123_encsize(encoding) * BITS;
+    format.rate = rate;
+    format.channels = channels;
+    format.byte_format = AO_FMT_NATIVE;
+    format.matrix = 0;
+    music.dev = ao_open_live(driver, &format, NULL);
+    music.quit.store(0);
+    music.player = music.dev ? new thread(musicWorker) : NULL;
+}
+
+void stopMusic()
+{
+    if (!music.mh)
+    {
+        return;
+    }
+    // At most one buffer, about 17 ms, is still playing when the player sees quit
+    if (music.player)
+    {
+        music.quit.store(1);
+        music.player->join();
+        delete music.player;
+        music.player = NULL;
+    }
+    /* clean up */
+    free(music.buffer);
+    if (music.dev)
+        ao_close(music.dev);
+    mpg123_close(music.mh);
+    mpg123_delete(music.mh);
+    mpg123_exit();
+    ao_shutdown();
+    music.mh = NULL;
+}
@@ -0,0 +1,11 @@
+#ifndef AUDIO_MUSIC_H
+#define AUDIO_MUSIC_H
+
+#include "common/common.h"
+
+/* Background music decoded with mpg123 and played with libao on its own thread, looping
+ * The blocking writes to the device stay off the render thread so they never pace its frames */
+void startMusic(const char *path);
+void stopMusic();
+
+#endif
@@ -0,0 +1,46 @@
+#include "common/arena.h"
+
+void *arenaAlloc(Arena &arena, size_t size, size_t align)
+{
+    if (!arena.blocks.empty())
+    {
+        size_t offset = (arena.used + align - 1) & ~(align - 1);
+        if (offset + size <= arena.sizes[arena.current])
+        {
+            arena.used = offset + size;
+            arena.allocations++;
+            arena.bytes += size;
+            return arena.blocks[arena.current] + offset;
+        }
+        arena.current++;
+    }
+    // Move on to the next kept block, or insert a new one there if it is too small
+    if (arena.current >= arena.blocks.size() || arena.sizes[arena.current] < size)
+    {
+        size_t blockSize = max((size_t)ARENA_BLOCK_SIZE, size);
+        arena.blocks.insert(arena.blocks.begin() + arena.current, (char *)malloc(blockSize));
+        arena.sizes.insert(arena.sizes.begin() + arena.current, blockSize);
+    }
+    arena.used = size;
+    arena.allocations++;
+    arena.bytes += size;
+    return arena.blocks[arena.current];
+}
+
+const char *arenaString(Arena &arena, const string &str)
+{
+    char *copy = (char *)arenaAlloc(arena, str.size() + 1, 1);
+    memcpy(copy, str.c_str(), str.size() + 1);
+    return copy;
+}
+
+void arenaReset(Arena &arena)
+{
+    arena.current = 0;
+    arena.used = 0;
+    arena.allocations = 0;
+    arena.bytes = 0;
+}
+
+/* Names, VAO handles and staged vertices of the objects created once at startup, never reset */
+Arena persistentArena;
@@ -0,0 +1,33 @@
+#ifndef COMMON_ARENA_H
+#define COMMON_ARENA_H
+
+#include "common/common.h"
+
+/*******************
+ * Arena allocator *
+ *******************/
+
+/* Bump allocator for objects that all die together, like everything a level owns
+ * Reset is O(1): it rewinds to the first block and keeps the blocks for the next user
+ * Memory is never handed back to the heap and the arena runs no destructors: plain data can simply be dropped,
+ * but whoever placement news an object owning memory elsewhere (a vector, a string) must call its destructor
+ * before the reset, like collectMeshUpload does for the upload jobs of a level */
+#define ARENA_BLOCK_SIZE (64 * 1024)
+
+struct Arena
+{
+    vector<char *> blocks;
+    vector<size_t> sizes;
+    size_t current; // block being filled
+    size_t used;    // bytes used in the current block
+    long allocations, bytes; // since the last reset
+};
+
+void *arenaAlloc(Arena &arena, size_t size, size_t align = sizeof(void *));
+const char *arenaString(Arena &arena, const string &str);
+void arenaReset(Arena &arena);
+
+/* Names, VAO handles and staged vertices of the objects created once at startup, never reset */
+extern Arena persistentArena;
+
+#endif
@@ -0,0 +1,13 @@
+#include "common/color.h"
+
+COLOR red = {255 / 255.0, 175 / 255.0, 135 / 255};
+COLOR green = {0.1255, 0.75, 0.333};
+COLOR black = {127 / 255.0, 150 / 255.0, 1.0};
+COLOR steel = {219 / 255.0, 252 / 255.0, 255 / 255.0};
+COLOR yellow = {229 / 255.0, 99 / 255.0, 153 / 255.0};
+COLOR coolblue = {66 / 255.0, 229 / 255.0, 244 / 255.0};
+COLOR coolgreen = {0 / 255.0, 153 / 255.0, 51 / 255.0};
+COLOR grey = {166 / 255.0, 166 / 255.0, 166 / 255.0};
+COLOR teal = {0, 153 / 255.0, 153 / 255.0};
+COLOR bg = {0.3f, 0.3f, 0.3f};
+COLOR blue = {0, 0, 1};
@@ -0,0 +1,27 @@
+#ifndef COMMON_COLOR_H
+#define COMMON_COLOR_H
+
+#include "common/common.h"
+
+struct COLOR
+{
+    float r;
+    float g;
+    float b;
+};
+
+typedef struct COLOR color;
+
+extern COLOR red;
+extern COLOR green;
+extern COLOR black;
+extern COLOR steel;
+extern COLOR yellow;
+extern COLOR coolblue;
+extern COLOR coolgreen;
+extern COLOR grey;
+extern COLOR teal;
+extern COLOR bg;
+extern COLOR blue;
+
+#endif
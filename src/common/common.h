@@ -0,0 +1,34 @@
+#ifndef COMMON_COMMON_H
+#define COMMON_COMMON_H
+
+/* Standard library, GL and glm headers every module builds on */
+#include <iostream>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <vector>
+#include <algorithm>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <time.h>
+#include <string.h>
+#include <ctime>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <stdint.h>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+#include <glm/gtx/transform.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
+
+using namespace std;
+
+#endif
@@ -0,0 +1,33 @@
+#include "hud/hud.h"
+#include "render/queue.h"
+
+Hud hud;
+
+void drawHud(int width, int height, double time, int score)
+{
+    // Sized to the framebuffer, so it scales with the window and on high DPI screens
+    float size = max(12.0f, height / 32.0f);
+    float margin = size;
+    float line = size * 1.6f;
+
+    drawText(margin, margin, size, "MOVES " + to_string(score), steel);
+    drawText(margin, margin + line, size, "TIME " + to_string((int)time), steel);
+
+    hud.statsFrames++;
+    if (time - hud.statsTime >= HUD_STATS_INTERVAL)
+    {
+        double fps = hud.statsFrames / (time - hud.statsTime);
+        double gpu = 0;
+        for (int i = 0; i < NUM_RENDER_LAYERS; i++)
+            gpu += frameStats.pass[i].gpu;
+        char stats[96];
+        snprintf(stats, sizeof(stats), "FPS %d  CPU %.1f MS  GPU %.1f MS  DRAWS %d", (int)(fps + 0.5),
+                 frameStats.frameCpu, gpu, lastRenderStats.draws);
+        hud.statsLine = stats;
+        hud.statsTime = time;
+        hud.statsFrames = 0;
+    }
+    drawText(margin, margin + 2 * line, size * 0.6f, hud.statsLine, grey);
+
+    flushText(width, height);
+}
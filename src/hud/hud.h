@@ -0,0 +1,22 @@
+#ifndef HUD_HUD_H
+#define HUD_HUD_H
+
+#include "hud/text.h"
+
+/* Screen space HUD: moves and time in the top left corner, frame statistics under them
+ * The statistics line is refreshed twice a second so the queued text, and with it the
+ * glyph quads, stays the same between most frames */
+#define HUD_STATS_INTERVAL 0.5
+
+struct Hud
+{
+    double statsTime;  // when the statistics line was last refreshed
+    int statsFrames;   // frames drawn since then
+    string statsLine;
+};
+
+extern Hud hud;
+
+void drawHud(int width, int height, double time, int score);
+
+#endif
@@ -0,0 +1,281 @@
+#include "hud/text.h"
+#include "render/shader.h"
+#include "render/queue.h"
+
+TextRenderer text;
+
+/* Printable characters of the font, lower case letters are drawn as capitals */
+const char glyphChars[] = " 0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ.,:-+=/%()";
+#define GLYPH_COUNT ((int)sizeof(glyphChars) - 1)
+
+/* One byte per column, bit 0 is the top row */
+const unsigned char glyphBits[GLYPH_COUNT][GLYPH_COLUMNS] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00}, // space
+    {0x3E, 0x51, 0x49, 0x45, 0x3E}, // 0
+    {0x00, 0x42, 0x7F, 0x40, 0x00}, // 1
+    {0x42, 0x61, 0x51, 0x49, 0x46}, // 2
+    {0x21, 0x41, 0x45, 0x4B, 0x31}, // 3
+    {0x18, 0x14, 0x12, 0x7F, 0x10}, // 4
+    {0x27, 0x45, 0x45, 0x45, 0x39}, // 5
+    {0x3C, 0x4A, 0x49, 0x49, 0x30}, // 6
+    {0x01, 0x71, 0x09, 0x05, 0x03}, // 7
+    {0x36, 0x49, 0x49, 0x49, 0x36}, // 8
+    {0x06, 0x49, 0x49, 0x29, 0x1E}, // 9
+    {0x7E, 0x11, 0x11, 0x11, 0x7E}, // A
+    {0x7F, 0x49, 0x49, 0x49, 0x36}, // B
+    {0x3E, 0x41, 0x41, 0x41, 0x22}, // C
+    {0x7F, 0x41, 0x41, 0x22, 0x1C}, // D
+    {0x7F, 0x49, 0x49, 0x49, 0x41}, // E
+    {0x7F, 0x09, 0x09, 0x09, 0x01}, // F
+    {0x3E, 0x41, 0x49, 0x49, 0x7A}, // G
+    {0x7F, 0x08, 0x08, 0x08, 0x7F}, // H
+    {0x00, 0x41, 0x7F, 0x41, 0x00}, // I
+    {0x20, 0x40, 0x41, 0x3F, 0x01}, // J
+    {0x7F, 0x08, 0x14, 0x22, 0x41}, // K
+    {0x7F, 0x40, 0x40, 0x40, 0x40}, // L
+    {0x7F, 0x02, 0x0C, 0x02, 0x7F}, // M
+    {0x7F, 0x04, 0x08, 0x10, 0x7F}, // N
+    {0x3E, 0x41, 0x41, 0x41, 0x3E}, // O
+    {0x7F, 0x09, 0x09, 0x09, 0x06}, // P
+    {0x3E, 0x41, 0x51, 0x21, 0x5E}, // Q
+    {0x7F, 0x09, 0x19, 0x29, 0x46}, // R
+    {0x46, 0x49, 0x49, 0x49, 0x31}, // S
+    {0x01, 0x01, 0x7F, 0x01, 0x01}, // T
+    {0x3F, 0x40, 0x40, 0x40, 0x3F}, // U
+    {0x1F, 0x20, 0x40, 0x20, 0x1F}, // V
+    {0x3F, 0x40, 0x38, 0x40, 0x3F}, // W
+    {0x63, 0x14, 0x08, 0x14, 0x63}, // X
+    {0x07, 0x08, 0x70, 0x08, 0x07}, // Y
+    {0x61, 0x51, 0x49, 0x45, 0x43}, // Z
+    {0x00, 0x60, 0x60, 0x00, 0x00}, // .
+    {0x00, 0x50, 0x30, 0x00, 0x00}, // ,
+    {0x00, 0x36, 0x36, 0x00, 0x00}, // :
+    {0x08, 0x08, 0x08, 0x08, 0x08}, // -
+    {0x08, 0x08, 0x3E, 0x08, 0x08}, // +
+    {0x14, 0x14, 0x14, 0x14, 0x14}, // =
+    {0x20, 0x10, 0x08, 0x04, 0x02}, // /
+    {0x23, 0x13, 0x08, 0x64, 0x62}, // %
+    {0x00, 0x1C, 0x22, 0x41, 0x00}, // (
+    {0x00, 0x41, 0x22, 0x1C, 0x00}, // )
+};
+
+/* Atlas cell of a character, -1 for characters the font doesn't have */
+int glyphIndex(char c)
+{
+    c = toupper((unsigned char)c);
+    const char *found = strchr(glyphChars, c);
+    return (c && found) ? (int)(found - glyphChars) : -1;
+}
+
+bool glyphPixel(int glyph, int column, int row)
+{
+    if (column < 0 || column >= GLYPH_COLUMNS || row < 0 || row >= GLYPH_ROWS)
+        return false;
+    return (glyphBits[glyph][column] >> row) & 1;
+}
+
+/* Distance from a point to the font pixel at (column, row), in font pixels */
+float pixelDistance(float x, float y, int column, int row)
+{
+    float dx = max(max(column - x, x - (column + 1)), 0.0f);
+    float dy = max(max(row - y, y - (row + 1)), 0.0f);
+    return sqrtf(dx * dx + dy * dy);
+}
+
+/* Signed distance field of one glyph into its atlas cell, 0.5 on the outline and above it inside
+ * The glyphs are at most 35 pixels so every texel simply measures against every pixel */
+void renderGlyphField(int glyph, GLubyte *atlas, int atlasWidth)
+{
+    int cellX = (glyph % ATLAS_GLYPHS_PER_ROW) * GLYPH_CELL_WIDTH;
+    int cellY = (glyph / ATLAS_GLYPHS_PER_ROW) * GLYPH_CELL_HEIGHT;
+    for (int ty = 0; ty < GLYPH_CELL_HEIGHT; ty++)
+    {
+        for (int tx = 0; tx < GLYPH_CELL_WIDTH; tx++)
+        {
+            float x = (tx + 0.5f - GLYPH_PADDING) / GLYPH_SCALE;
+            float y = (ty + 0.5f - GLYPH_PADDING) / GLYPH_SCALE;
+            bool inside = glyphPixel(glyph, (int)floorf(x), (int)floorf(y));
+            // Inside, the distance to the nearest unlit pixel of the glyph or the ring around it
+            float nearest = 1e9f;
+            for (int row = -1; row <= GLYPH_ROWS; row++)
+            {
+                for (int column = -1; column <= GLYPH_COLUMNS; column++)
+                {
+                    if (glyphPixel(glyph, column, row) != inside)
+                        nearest = min(nearest, pixelDistance(x, y, column, row));
+                }
+            }
+            float distance = (inside ? nearest : -nearest) * GLYPH_SCALE;
+            float value = 0.5f + 0.5f * distance / GLYPH_PADDING;
+            atlas[(cellY + ty) * atlasWidth + cellX + tx] = (GLubyte)(min(max(value, 0.0f), 1.0f) * 255 + 0.5f);
+        }
+    }
+}
+
+void initText()
+{
+    text.programID = LoadShaders("Sample_GL_text.vert", NULL, "Sample_GL_text.frag");
+    if (!text.programID)
+        return;
+    text.ScreenID = glGetUniformLocation(text.programID, "screenSize");
+    glUseProgram(text.programID);
+    glUniform1i(glGetUniformLocation(text.programID, "atlas"), 0);
+
+    int atlasWidth = ATLAS_GLYPHS_PER_ROW * GLYPH_CELL_WIDTH;
+    int atlasHeight = ((GLYPH_COUNT + ATLAS_GLYPHS_PER_ROW - 1) / ATLAS_GLYPHS_PER_ROW) * GLYPH_CELL_HEIGHT;
+    vector<GLubyte> atlas(atlasWidth * atlasHeight, 0);
+    for (int glyph = 0; glyph < GLYPH_COUNT; glyph++)
+        renderGlyphField(glyph, &atlas[0], atlasWidth);
+
+    glGenTextures(1, &text.texture);
+    glBindTexture(GL_TEXTURE_2D, text.texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, atlasWidth, atlasHeight, 0, GL_RED, GL_UNSIGNED_BYTE, &atlas[0]);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    glGenVertexArrays(1, &text.vao);
+    glGenBuffers(1, &text.vbo);
+    glBindVertexArray(text.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, text.vbo);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void *)offsetof(TextVertex, position));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void *)offsetof(TextVertex, texCoord));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(TextVertex), (void *)offsetof(TextVertex, color));
+    glBindVertexArray(0);
+    text.vertexCapacity = 0;
+    text.vertexCount = 0;
+}
+
+/* Glyphs advance by one column more than their width */
+float textWidth(float size, const string &str)
+{
+    float pixel = size / GLYPH_ROWS;
+    return str.empty() ? 0 : ((GLYPH_COLUMNS + 1) * str.size() - 1) * pixel;
+}
+
+/* Queue a string with its top left corner at (x, y) in framebuffer pixels */
+void drawText(float x, float y, float size, const string &str, COLOR color)
+{
+    TextRun run = {x, y, size, color, str};
+    text.runs.push_back(run);
+}
+
+bool sameRun(const TextRun &a, const TextRun &b)
+{
+    return a.x == b.x && a.y == b.y && a.size == b.size && a.color.r == b.color.r &&
+           a.color.g == b.color.g && a.color.b == b.color.b && a.text == b.text;
+}
+
+bool sameRuns(const vector<TextRun> &a, const vector<TextRun> &b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        if (!sameRun(a[i], b[i]))
+            return false;
+    }
+    return true;
+}
+
+void appendGlyph(float x, float y, float pixel, int glyph, const GLubyte color[4])
+{
+    float atlasWidth = ATLAS_GLYPHS_PER_ROW * GLYPH_CELL_WIDTH;
+    float atlasHeight = ((GLYPH_COUNT + ATLAS_GLYPHS_PER_ROW - 1) / ATLAS_GLYPHS_PER_ROW) * GLYPH_CELL_HEIGHT;
+    float u0 = (glyph % ATLAS_GLYPHS_PER_ROW) * GLYPH_CELL_WIDTH / atlasWidth;
+    float v0 = (glyph / ATLAS_GLYPHS_PER_ROW) * GLYPH_CELL_HEIGHT / atlasHeight;
+    float u1 = u0 + GLYPH_CELL_WIDTH / atlasWidth;
+    float v1 = v0 + GLYPH_CELL_HEIGHT / atlasHeight;
+
+    // The quad covers the padding too so the outline isn't clipped
+    float x0 = x - pixel * GLYPH_PADDING / GLYPH_SCALE;
+    float y0 = y - pixel * GLYPH_PADDING / GLYPH_SCALE;
+    float x1 = x0 + pixel * GLYPH_CELL_WIDTH / GLYPH_SCALE;
+    float y1 = y0 + pixel * GLYPH_CELL_HEIGHT / GLYPH_SCALE;
+
+    TextVertex corners[4] = {
+        {{x0, y0}, {u0, v0}, {color[0], color[1], color[2], color[3]}},
+        {{x1, y0}, {u1, v0}, {color[0], color[1], color[2], color[3]}},
+        {{x1, y1}, {u1, v1}, {color[0], color[1], color[2], color[3]}},
+        {{x0, y1}, {u0, v1}, {color[0], color[1], color[2], color[3]}},
+    };
+    static const int order[6] = {0, 1, 2, 0, 2, 3};
+    for (int i = 0; i < 6; i++)
+        text.vertices.push_back(corners[order[i]]);
+}
+
+void buildTextVertices()
+{
+    text.vertices.clear();
+    for (size_t i = 0; i < text.runs.size(); i++)
+    {
+        const TextRun &run = text.runs[i];
+        float pixel = run.size / GLYPH_ROWS;
+        GLubyte color[4] = {(GLubyte)(run.color.r * 255 + 0.5f), (GLubyte)(run.color.g * 255 + 0.5f),
+                            (GLubyte)(run.color.b * 255 + 0.5f), 255};
+        for (size_t c = 0; c < run.text.size(); c++)
+        {
+            int glyph = glyphIndex(run.text[c]);
+            if (glyph > 0)
+                appendGlyph(run.x + c * (GLYPH_COLUMNS + 1) * pixel, run.y, pixel, glyph, color);
+        }
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, text.vbo);
+    if ((int)text.vertices.size() > text.vertexCapacity)
+    {
+        text.vertexCapacity = max((int)text.vertices.size(), 2 * text.vertexCapacity);
+        glBufferData(GL_ARRAY_BUFFER, text.vertexCapacity * sizeof(TextVertex), NULL, GL_DYNAMIC_DRAW);
+    }
+    if (!text.vertices.empty())
+        glBufferSubData(GL_ARRAY_BUFFER, 0, text.vertices.size() * sizeof(TextVertex), &text.vertices[0]);
+    text.vertexCount = text.vertices.size();
+    text.drawnRuns.swap(text.runs);
+    text.rebuilds++;
+}
+
+/* Draw every string queued this frame over the whole framebuffer in one draw */
+void flushText(int width, int height)
+{
+    if (!text.programID)
+    {
+        text.runs.clear();
+        return;
+    }
+    text.frames++;
+    if (!sameRuns(text.runs, text.drawnRuns))
+        buildTextVertices();
+    text.runs.clear();
+    if (text.vertexCount == 0 || width <= 0 || height <= 0)
+        return;
+
+    int sample = beginPassTimer(LAYER_HUD);
+    setViewport(0, 0, width, height);
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    glUseProgram(text.programID);
+    glUniform2f(text.ScreenID, width, height);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, text.texture);
+    glBindVertexArray(text.vao);
+    glDrawArrays(GL_TRIANGLES, 0, text.vertexCount);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glUseProgram(0);
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+    endPassTimer(sample);
+}
+
+void printTextStats()
+{
+    printf("text: %d glyph vertices, quads rebuilt in %d of %d frames\n", text.vertexCount, text.rebuilds, text.frames);
+}
@@ -0,0 +1,59 @@
+#ifndef HUD_TEXT_H
+#define HUD_TEXT_H
+
+#include "common/color.h"
+
+/************
+ * SDF text *
+ ************/
+
+/* The glyphs of a built in 5x7 pixel font are turned into signed distance fields in one atlas at
+ * startup, so HUD text stays sharp at any size. Strings are queued in screen pixels during the frame
+ * and drawn in a single batched draw, the glyph quads are only rebuilt when the queued text changes */
+#define GLYPH_COLUMNS 5
+#define GLYPH_ROWS 7
+#define GLYPH_SCALE 4   // atlas texels per font pixel
+#define GLYPH_PADDING 6 // texels around each glyph, also the distance range stored in the field
+#define GLYPH_CELL_WIDTH (GLYPH_COLUMNS * GLYPH_SCALE + 2 * GLYPH_PADDING)
+#define GLYPH_CELL_HEIGHT (GLYPH_ROWS * GLYPH_SCALE + 2 * GLYPH_PADDING)
+#define ATLAS_GLYPHS_PER_ROW 16
+
+struct TextVertex
+{
+    GLfloat position[2]; // framebuffer pixels, origin at the top left
+    GLfloat texCoord[2];
+    GLubyte color[4];
+};
+
+/* One queued string, size is the height of a capital in pixels */
+struct TextRun
+{
+    float x, y, size;
+    COLOR color;
+    string text;
+};
+
+struct TextRenderer
+{
+    GLuint programID; // 0 when the text shaders failed to load
+    GLint ScreenID;
+    GLuint texture;
+    GLuint vao, vbo;
+    int vertexCapacity;
+    int vertexCount;
+    vector<TextRun> runs;      // queued this frame
+    vector<TextRun> drawnRuns; // the runs the buffer currently holds
+    vector<TextVertex> vertices;
+    int rebuilds; // frames that regenerated the glyph quads
+    int frames;
+};
+
+extern TextRenderer text;
+
+void initText();
+float textWidth(float size, const string &str);
+void drawText(float x, float y, float size, const string &str, COLOR color);
+void flushText(int width, int height);
+void printTextStats();
+
+#endif
@@ -0,0 +1,380 @@
+#include "level/chunks.h"
+#include "render/camera.h"
+#include "render/shadow.h"
+#include "sim/board.h"
+
+/* Projected chunk size in pixels below which a level is used, set with --lod
+ * At 600 pixels high the follow camera sees a chunk at 340 pixels 10 units ahead and 160 pixels 21 units ahead,
+ * so the column the block is in stays full, the next one is top faces and the last prefetch rows are impostors */
+float lodTopPixels = 320, lodImpostorPixels = 160;
+GLuint impostorProgramID; // 0 draws impostor chunks with their top faces
+
+ChunkStreamer *streamer;
+
+/* Append a box to a mesh being built */
+void appendBox(vector<Vertex> &vertices, vector<GLushort> &indices, glm::vec3 center, glm::vec3 half, COLOR c)
+{
+    GLushort base = (GLushort)vertices.size();
+    Vertex box[BOX_VERTICES];
+    buildBox(half.x, half.y, half.z, box);
+    for (int i = 0; i < BOX_VERTICES; i++)
+    {
+        Vertex v = box[i];
+        v.position[0] += center.x;
+        v.position[1] += center.y;
+        v.position[2] += center.z;
+        v.color[0] = (GLubyte)(c.r * 255 + 0.5f);
+        v.color[1] = (GLubyte)(c.g * 255 + 0.5f);
+        v.color[2] = (GLubyte)(c.b * 255 + 0.5f);
+        v.color[3] = 255;
+        vertices.push_back(v);
+    }
+    for (int i = 0; i < 36; i++)
+        indices.push_back(base + boxIndices[i]);
+}
+
+/* Append an upward facing quad at height y */
+void appendQuad(vector<Vertex> &vertices, vector<GLushort> &indices, float x0, float z0, float x1, float z1, float y, COLOR c)
+{
+    GLushort base = (GLushort)vertices.size();
+    for (int i = 0; i < 4; i++)
+    {
+        Vertex v;
+        v.position[0] = (i & 1) ? x1 : x0;
+        v.position[1] = y;
+        v.position[2] = (i & 2) ? z1 : z0;
+        v.normal[0] = 0;
+        v.normal[1] = 1;
+        v.normal[2] = 0;
+        v.color[0] = (GLubyte)(c.r * 255 + 0.5f);
+        v.color[1] = (GLubyte)(c.g * 255 + 0.5f);
+        v.color[2] = (GLubyte)(c.b * 255 + 0.5f);
+        v.color[3] = 255;
+        vertices.push_back(v);
+    }
+    static const GLushort quad[6] = {0, 2, 3, 0, 3, 1};
+    for (int i = 0; i < 6; i++)
+        indices.push_back(base + quad[i]);
+}
+
+/* Hand a built mesh over to be uploaded, nothing for an empty one */
+void packChunkLod(ChunkSlot &slot, int lod, vector<Vertex> &vertices, vector<GLushort> &indices, VertexLayout layout)
+{
+    slot.upload[lod] = NULL;
+    slot.triangles[lod] = indices.size() / 3;
+    if (indices.empty())
+        return;
+    slot.upload[lod] = newMeshUpload();
+    // A chunk merges cells of different colors into one mesh, so unlike sprites it keeps them per vertex
+    bool vertexColors = lod != CHUNK_LOD_IMPOSTOR;
+    packMesh(slot.upload[lod]->mesh, GL_TRIANGLES, vertices.size(), &vertices[0], indices.size(), &indices[0], layout, GL_FILL, NULL, vertexColors);
+}
+
+/* Build and pack every level of detail of a chunk, relative to the chunk corner so SNORM16 positions stay precise */
+void buildChunkMesh(ChunkSlot &slot)
+{
+    const unsigned char *cells = worldChunk(slot.cx, slot.cz);
+    vector<Vertex> fullVertices, topVertices;
+    vector<GLushort> fullIndices, topIndices;
+    memset(slot.texels, 0, sizeof(slot.texels));
+    for (int z = 0; z < CHUNK_CELLS; z++)
+    {
+        for (int x = 0; x < CHUNK_CELLS; x++)
+        {
+            unsigned char cell = cells[z * CHUNK_CELLS + x];
+            if (!(cell & (CELL_TILE | CELL_FRAGILE | CELL_GOAL)))
+                continue;
+            COLOR c = ((slot.cx * CHUNK_CELLS + x + slot.cz * CHUNK_CELLS + z) & 1) ? yellow : black;
+            if (cell & CELL_GOAL)
+                c = bg;
+            else if (cell & CELL_FRAGILE)
+                c = teal;
+            appendBox(fullVertices, fullIndices, glm::vec3(x * 0.5f, -0.7f, z * 0.5f), glm::vec3(0.25f, 0.05f, 0.25f), c);
+            appendQuad(topVertices, topIndices, x * 0.5f - 0.25f, z * 0.5f - 0.25f, x * 0.5f + 0.25f, z * 0.5f + 0.25f, BOARD_TOP, c);
+            GLubyte *texel = &slot.texels[(z * CHUNK_CELLS + x) * 4];
+            texel[0] = (GLubyte)(c.r * 255 + 0.5f);
+            texel[1] = (GLubyte)(c.g * 255 + 0.5f);
+            texel[2] = (GLubyte)(c.b * 255 + 0.5f);
+            texel[3] = 255;
+        }
+    }
+    packChunkLod(slot, CHUNK_LOD_FULL, fullVertices, fullIndices, VERTEX_LAYOUT_SNORM16);
+    packChunkLod(slot, CHUNK_LOD_TOP, topVertices, topIndices, VERTEX_LAYOUT_SNORM16);
+
+    // The impostor quad covers the whole chunk, the impostor shader maps its positions to texels
+    vector<Vertex> impostorVertices;
+    vector<GLushort> impostorIndices;
+    if (!fullIndices.empty())
+        appendQuad(impostorVertices, impostorIndices, -0.25f, -0.25f, CHUNK_CELLS * 0.5f - 0.25f, CHUNK_CELLS * 0.5f - 0.25f, BOARD_TOP, steel);
+    packChunkLod(slot, CHUNK_LOD_IMPOSTOR, impostorVertices, impostorIndices, VERTEX_LAYOUT_FLOAT);
+}
+
+void streamWorker()
+{
+    for (;;)
+    {
+        int job;
+        {
+            unique_lock<mutex> guard(streamer->lock);
+            streamer->wake.wait(guard, [] { return !streamer->jobs.empty(); });
+            job = streamer->jobs.front();
+            streamer->jobs.pop_front();
+        }
+        ChunkSlot &slot = streamer->slots[job];
+        buildChunkMesh(slot);
+        slot.state.store(CHUNK_BUILT, memory_order_release);
+    }
+}
+
+void startStreaming()
+{
+    streamer = new ChunkStreamer();
+    for (int i = 0; i < MAX_RESIDENT_CHUNKS; i++)
+    {
+        streamer->slots[i].state.store(CHUNK_FREE);
+        for (int lod = 0; lod < NUM_CHUNK_LODS; lod++)
+        {
+            streamer->slots[i].upload[lod] = NULL;
+            streamer->slots[i].lods[lod] = NULL;
+        }
+        streamer->slots[i].impostorTexture = 0;
+    }
+    thread(streamWorker).detach();
+}
+
+/* Chunks wanted around the block's chunk, nearest first, then the prefetch rows along the move direction */
+void wantedChunks(int cx, int cz, int direction, vector<pair<int, int> > &wanted)
+{
+    wanted.clear();
+    for (int ring = 0; ring <= STREAM_RADIUS; ring++)
+        for (int dz = -ring; dz <= ring; dz++)
+            for (int dx = -ring; dx <= ring; dx++)
+                if (max(abs(dx), abs(dz)) == ring)
+                    wanted.push_back(make_pair(cx + dx, cz + dz));
+
+    int mx = (int)rollDirections[direction].x, mz = (int)rollDirections[direction].z;
+    for (int k = 1; k <= STREAM_PREFETCH; k++)
+        for (int side = -STREAM_RADIUS; side <= STREAM_RADIUS; side++)
+            wanted.push_back(make_pair(cx + mx * (STREAM_RADIUS + k) + mz * side, cz + mz * (STREAM_RADIUS + k) + mx * side));
+}
+
+/* Pick a slot for a new chunk, a free one or the least recently wanted resident one not wanted this frame */
+int chunkVictim()
+{
+    int victim = -1;
+    for (int i = 0; i < MAX_RESIDENT_CHUNKS; i++)
+    {
+        ChunkSlot &slot = streamer->slots[i];
+        int state = slot.state.load(memory_order_acquire);
+        if (state == CHUNK_FREE)
+            return i;
+        if (state == CHUNK_RESIDENT && slot.lastWanted != streamer->frame &&
+            (victim < 0 || slot.lastWanted < streamer->slots[victim].lastWanted))
+            victim = i;
+    }
+    return victim;
+}
+
+/* Once per frame on the GL thread: move built chunks through the upload thread and queue the chunks the block will need next */
+void updateStreaming(const BlockPose &block)
+{
+    if (!streamer)
+    {
+        return;
+    }
+    streamer->frame++;
+
+    int uploads = 0;
+    for (int i = 0; i < MAX_RESIDENT_CHUNKS; i++)
+    {
+        ChunkSlot &slot = streamer->slots[i];
+        int state = slot.state.load(memory_order_acquire);
+        if (state == CHUNK_BUILT && uploads < MAX_CHUNK_UPLOADS_PER_FRAME)
+        {
+            for (int lod = 0; lod < NUM_CHUNK_LODS; lod++)
+                if (slot.upload[lod])
+                    queueMeshUpload(slot.upload[lod]);
+            uploads++;
+            slot.state.store(CHUNK_UPLOADING, memory_order_release);
+            state = CHUNK_UPLOADING;
+        }
+        if (state == CHUNK_UPLOADING)
+        {
+            int pending = 0;
+            for (int lod = 0; lod < NUM_CHUNK_LODS; lod++)
+            {
+                if (!slot.upload[lod])
+                    continue;
+                slot.lods[lod] = collectMeshUpload(slot.upload[lod]);
+                if (slot.lods[lod])
+                    slot.upload[lod] = NULL; // the job and its CPU copy are freed once collected
+                else
+                    pending = 1;
+            }
+            if (pending)
+                continue;
+            if (slot.lods[CHUNK_LOD_IMPOSTOR])
+            {
+                glGenTextures(1, &slot.impostorTexture);
+                glBindTexture(GL_TEXTURE_2D, slot.impostorTexture);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, CHUNK_CELLS, CHUNK_CELLS, 0, GL_RGBA, GL_UNSIGNED_BYTE, slot.texels);
+            }
+            slot.state.store(CHUNK_RESIDENT, memory_order_release);
+            streamer->residentVersion++;
+            streamer->stats.uploads++;
+            markShadowDirty();
+        }
+    }
+
+    int cx = worldToCell(block.position.x) / CHUNK_CELLS, cz = worldToCell(block.position.z) / CHUNK_CELLS;
+    vector<pair<int, int> > wanted;
+    wantedChunks(cx, cz, block.roll.direction, wanted);
+
+    // Mark the wanted chunks that already have a slot before choosing victims
+    vector<pair<int, int> > missing;
+    for (size_t w = 0; w < wanted.size(); w++)
+    {
+        int x = wanted[w].first, z = wanted[w].second;
+        if (x < 0 || z < 0 || x >= world.header.chunksX || z >= world.header.chunksZ)
+            continue;
+        int found = 0;
+        for (int i = 0; i < MAX_RESIDENT_CHUNKS && !found; i++)
+        {
+            ChunkSlot &slot = streamer->slots[i];
+            if (slot.state.load(memory_order_acquire) != CHUNK_FREE && slot.cx == x && slot.cz == z)
+            {
+                slot.lastWanted = streamer->frame;
+                found = 1;
+            }
+        }
+        if (!found)
+            missing.push_back(wanted[w]);
+    }
+
+    for (size_t w = 0; w < missing.size(); w++)
+    {
+        int victim = chunkVictim();
+        if (victim < 0)
+        {
+            streamer->stats.misses++;
+            break;
+        }
+        ChunkSlot &slot = streamer->slots[victim];
+        if (slot.state.load(memory_order_acquire) == CHUNK_RESIDENT)
+        {
+            streamer->stats.evictions++;
+            streamer->residentVersion++;
+            markShadowDirty();
+            releaseWorldChunk(slot.cx, slot.cz);
+        }
+        for (int lod = 0; lod < NUM_CHUNK_LODS; lod++)
+        {
+            if (slot.lods[lod])
+            {
+                destroy3DObject(slot.lods[lod]);
+                slot.lods[lod] = NULL;
+            }
+        }
+        if (slot.impostorTexture)
+        {
+            glDeleteTextures(1, &slot.impostorTexture);
+            slot.impostorTexture = 0;
+        }
+        slot.cx = missing[w].first;
+        slot.cz = missing[w].second;
+        slot.lastWanted = streamer->frame;
+        slot.state.store(CHUNK_LOADING, memory_order_release);
+        {
+            lock_guard<mutex> guard(streamer->lock);
+            streamer->jobs.push_back(victim);
+        }
+        streamer->wake.notify_one();
+        streamer->stats.loads++;
+    }
+}
+
+/* Height in pixels a chunk appears in a perspective view */
+float chunkScreenSize(const RenderView &view, glm::vec3 center)
+{
+    float radius = CHUNK_CELLS * 0.5f * 0.7071f;
+    glm::vec4 clip = view.VP * glm::vec4(center, 1);
+    if (clip.w <= 0.1f)
+        return 1e9f;
+    // projectionP[1][1] is the focal length, the zoom scales the world before the view
+    float focal = Matrices.projectionP[1][1] * exp(camera.zoom);
+    return radius * focal * view.height / clip.w;
+}
+
+/* Whether every corner of a chunk is behind the eye, such a chunk is out of view but may still cast a shadow */
+int chunkBehindView(const RenderView &view, glm::vec3 corner)
+{
+    float span = CHUNK_CELLS * 0.5f;
+    for (int i = 0; i < 4; i++)
+    {
+        glm::vec3 p = corner + glm::vec3((i & 1) ? span : 0, BOARD_TOP, (i & 2) ? span : 0) - glm::vec3(0.25f, 0, 0.25f);
+        if ((view.VP * glm::vec4(p, 1)).w > 0)
+            return 0;
+    }
+    return 1;
+}
+
+/* Queue the meshes of the resident chunks with the other tiles, simplified with distance in a single perspective view */
+void submitStreamedChunks(GLuint program, const vector<RenderView> &views)
+{
+    if (!streamer)
+    {
+        return;
+    }
+    StreamStats &stats = streamer->stats;
+    memset(stats.chunksAtLod, 0, sizeof(stats.chunksAtLod));
+    stats.trianglesDrawn = stats.trianglesFull = 0;
+    int useLod = proj_type && views.size() == 1;
+
+    for (int i = 0; i < MAX_RESIDENT_CHUNKS; i++)
+    {
+        ChunkSlot &slot = streamer->slots[i];
+        if (slot.state.load(memory_order_acquire) != CHUNK_RESIDENT || !slot.lods[CHUNK_LOD_FULL])
+            continue;
+        glm::vec3 corner(slot.cx * CHUNK_CELLS * 0.5f, 0, slot.cz * CHUNK_CELLS * 0.5f);
+        int lod = CHUNK_LOD_FULL;
+        if (useLod)
+        {
+            float size = chunkScreenSize(views[0], corner + glm::vec3(CHUNK_CELLS * 0.25f, BOARD_TOP, CHUNK_CELLS * 0.25f));
+            // The top faces are enough for the shadow of a chunk behind the camera
+            if (chunkBehindView(views[0], corner))
+                lod = CHUNK_LOD_TOP;
+            else if (size < lodImpostorPixels)
+                lod = impostorProgramID ? CHUNK_LOD_IMPOSTOR : CHUNK_LOD_TOP;
+            else if (size < lodTopPixels)
+                lod = CHUNK_LOD_TOP;
+        }
+        glm::mat4 model = glm::translate(corner);
+        if (lod == CHUNK_LOD_IMPOSTOR)
+            submit3DObject(impostorProgramID, slot.lods[lod], model, steel, LAYER_TILES, slot.impostorTexture);
+        else
+            submit3DObject(program, slot.lods[lod], model, steel, LAYER_TILES);
+        stats.chunksAtLod[lod]++;
+        stats.trianglesDrawn += slot.triangles[lod];
+        stats.trianglesFull += slot.triangles[CHUNK_LOD_FULL];
+    }
+}
+
+void printStreamStats()
+{
+    if (!streamer)
+    {
+        return;
+    }
+    cout << "chunks loaded: " << streamer->stats.loads << " uploaded: " << streamer->stats.uploads
+         << " evicted: " << streamer->stats.evictions << " missed: " << streamer->stats.misses
+         << " resident slots: " << MAX_RESIDENT_CHUNKS << endl;
+    const StreamStats &stats = streamer->stats;
+    printf("chunks full: %d top faces: %d impostors: %d  triangles: %ld of %ld (%.1f%% saved)\n",
+           stats.chunksAtLod[CHUNK_LOD_FULL], stats.chunksAtLod[CHUNK_LOD_TOP], stats.chunksAtLod[CHUNK_LOD_IMPOSTOR],
+           stats.trianglesDrawn, stats.trianglesFull,
+           stats.trianglesFull ? 100.0 * (stats.trianglesFull - stats.trianglesDrawn) / stats.trianglesFull : 0.0);
+}
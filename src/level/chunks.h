@@ -0,0 +1,94 @@
+#ifndef LEVEL_CHUNKS_H
+#define LEVEL_CHUNKS_H
+
+#include "level/world.h"
+#include "render/queue.h"
+#include "render/upload.h"
+#include "sim/block.h"
+
+/*******************
+ * Chunk streaming *
+ *******************/
+
+/* Only the chunks around the block of a streamed world have meshes, the rest of the world is never read
+ * The resident set is a fixed pool of slots, a square of STREAM_RADIUS chunks around the block
+ * plus STREAM_PREFETCH rows ahead of the last move, reusing the least recently wanted slot
+ * A detached worker thread builds and packs chunk meshes from the mapped file, the GL thread queues a few per frame
+ * to the upload thread and picks up their VAOs once the buffers are on the GPU */
+#define STREAM_RADIUS 2
+#define STREAM_PREFETCH 2
+#define STREAM_SPAN (2 * STREAM_RADIUS + 1)
+#define MAX_RESIDENT_CHUNKS (STREAM_SPAN * STREAM_SPAN + STREAM_PREFETCH * STREAM_SPAN)
+#define MAX_CHUNK_UPLOADS_PER_FRAME 2
+
+/* In a single perspective view chunks far enough to look small are drawn simpler
+ * FULL - every tile as a box, 12 triangles
+ * TOP - only the top face of every tile, 2 triangles
+ * IMPOSTOR - one quad with a texel per tile, 2 triangles for the whole chunk */
+enum ChunkLod
+{
+    CHUNK_LOD_FULL,
+    CHUNK_LOD_TOP,
+    CHUNK_LOD_IMPOSTOR,
+    NUM_CHUNK_LODS
+};
+
+/* Projected chunk size in pixels below which a level is used, set with --lod */
+extern float lodTopPixels, lodImpostorPixels;
+extern GLuint impostorProgramID; // 0 draws impostor chunks with their top faces
+
+/* Owner of a slot: the GL thread for FREE, UPLOADING and RESIDENT, the worker while LOADING, handed back as BUILT */
+enum ChunkSlotState
+{
+    CHUNK_FREE,
+    CHUNK_LOADING,
+    CHUNK_BUILT,
+    CHUNK_UPLOADING,
+    CHUNK_RESIDENT
+};
+
+struct ChunkSlot
+{
+    atomic<int> state; // ChunkSlotState
+    int cx, cz;
+    long lastWanted;   // frame the chunk was last in the wanted set, for LRU eviction
+    MeshUpload *upload[NUM_CHUNK_LODS]; // packed meshes from the worker, NULL for an empty chunk
+    VAO *lods[NUM_CHUNK_LODS];          // NULL for an empty chunk
+    int triangles[NUM_CHUNK_LODS];
+    GLubyte texels[CHUNK_BYTES * 4];    // impostor colors, a texel per cell and alpha 0 without a tile
+    GLuint impostorTexture;
+};
+
+struct StreamStats
+{
+    long loads, evictions, uploads;
+    long misses; // wanted chunks left without a mesh because every slot was busy
+    // Last frame
+    int chunksAtLod[NUM_CHUNK_LODS];
+    long trianglesDrawn, trianglesFull; // drawn, and as if every chunk was drawn in full
+};
+
+/* Shared with the worker, allocated once and never freed as the detached worker outlives main() */
+struct ChunkStreamer
+{
+    ChunkSlot slots[MAX_RESIDENT_CHUNKS];
+    mutex lock;
+    condition_variable wake;
+    deque<int> jobs; // slots to load, guarded by lock
+    long frame;
+    long residentVersion; // bumped whenever a chunk becomes resident or is evicted
+    StreamStats stats;
+};
+
+extern ChunkStreamer *streamer;
+
+void appendBox(vector<Vertex> &vertices, vector<GLushort> &indices, glm::vec3 center, glm::vec3 half, COLOR c);
+void appendQuad(vector<Vertex> &vertices, vector<GLushort> &indices, float x0, float z0, float x1, float z1, float y, COLOR c);
+void startStreaming();
+void updateStreaming(const BlockPose &block);
+float chunkScreenSize(const RenderView &view, glm::vec3 center);
+int chunkBehindView(const RenderView &view, glm::vec3 corner);
+void submitStreamedChunks(GLuint program, const vector<RenderView> &views);
+void printStreamStats();
+
+#endif
@@ -0,0 +1,238 @@
+#include "level/gpu_cull.h"
+#include "render/shader.h"
+#include "render/lighting.h"
+#include "sim/block.h"
+
+GpuCuller gpuCull;
+
+int gpuCullRequested = 0;
+float gpuCullTopDistance = 20; // view depth beyond which tiles are drawn as top faces
+
+/* Box and top face of one tile around the origin in a single buffer pair, the instance moves them into place */
+void initGpuCullMesh()
+{
+    vector<Vertex> vertices;
+    vector<GLushort> indices;
+    appendBox(vertices, indices, glm::vec3(0, -0.7f, 0), glm::vec3(0.25f, 0.05f, 0.25f), steel);
+    gpuCull.boxIndices = indices.size();
+    appendQuad(vertices, indices, -0.25f, -0.25f, 0.25f, 0.25f, BOARD_TOP, steel);
+    gpuCull.topIndices = indices.size() - gpuCull.boxIndices;
+
+    PackedMesh mesh;
+    packMesh(mesh, GL_TRIANGLES, vertices.size(), &vertices[0], indices.size(), &indices[0], VERTEX_LAYOUT_FLOAT, GL_FILL);
+    // Keep 16 bit indices so both meshes share one index type in the indirect draw
+    vector<GLubyte> shortIndices(indices.size() * sizeof(GLushort));
+    memcpy(&shortIndices[0], &indices[0], shortIndices.size());
+    mesh.IndexType = GL_UNSIGNED_SHORT;
+    mesh.indices = &shortIndices[0];
+    mesh.indexBytes = shortIndices.size();
+    uploadMeshBuffers(mesh, &gpuCull.meshVertices, &gpuCull.meshIndices);
+    VAO *vao = createMeshVAO(mesh, gpuCull.meshVertices, gpuCull.meshIndices);
+    gpuCull.meshVAO = vao->VertexArrayID;
+    delete vao;
+
+    // Per instance position offset and color from the compacted visible buffer
+    glGenBuffers(1, &gpuCull.visible);
+    glBindVertexArray(gpuCull.meshVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, gpuCull.visible);
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(TileInstance), (void *)offsetof(TileInstance, position));
+    glEnableVertexAttribArray(3);
+    glVertexAttribDivisor(3, 1);
+    glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(TileInstance), (void *)offsetof(TileInstance, color));
+    glEnableVertexAttribArray(4);
+    glVertexAttribDivisor(4, 1);
+
+    // The shadow pass takes every tile, only the position offset straight from the tile buffer
+    vao = createMeshVAO(mesh, gpuCull.meshVertices, gpuCull.meshIndices);
+    gpuCull.shadowVAO = vao->VertexArrayID;
+    delete vao;
+    glBindVertexArray(gpuCull.shadowVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, gpuCull.tiles);
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(TileInstance), (void *)offsetof(TileInstance, position));
+    glEnableVertexAttribArray(3);
+    glVertexAttribDivisor(3, 1);
+    glBindVertexArray(0);
+}
+
+/* Load the programs and buffers, leaves gpuCull disabled when GL 4.3 or a shader is missing */
+void initGpuCull()
+{
+    if (!gpuCullRequested)
+    {
+        return;
+    }
+    if (!GLAD_GL_VERSION_4_3)
+    {
+        cout << "GPU culling needs OpenGL 4.3, the context is " << glGetString(GL_VERSION) << ", drawing chunks from the CPU" << endl;
+        return;
+    }
+    gpuCull.cullProgram = LoadComputeShader("Sample_GL_cull.comp");
+    gpuCull.drawProgram = LoadShaders("Sample_GL_instanced.vert", NULL, "Sample_GL.frag");
+    gpuCull.shadowProgram = LoadShaders("Sample_GL_shadow_instanced.vert", NULL, "Sample_GL_shadow.frag");
+    if (!gpuCull.cullProgram || !gpuCull.drawProgram || !gpuCull.shadowProgram)
+    {
+        cout << "GPU culling shaders failed to build, drawing chunks from the CPU" << endl;
+        return;
+    }
+    gpuCull.planesID = glGetUniformLocation(gpuCull.cullProgram, "planes");
+    gpuCull.depthRowID = glGetUniformLocation(gpuCull.cullProgram, "depthRow");
+    gpuCull.tileCountID = glGetUniformLocation(gpuCull.cullProgram, "tileCount");
+    gpuCull.topDistanceID = glGetUniformLocation(gpuCull.cullProgram, "topDistance");
+    gpuCull.shadowMatrixID = glGetUniformLocation(gpuCull.shadowProgram, "MVP");
+    registerProgram(gpuCull.drawProgram);
+    bindLightingBlock(gpuCull.drawProgram);
+
+    glGenBuffers(1, &gpuCull.tiles);
+    initGpuCullMesh();
+    glGenBuffers(1, &gpuCull.commands);
+    gpuCull.capacity = 0;
+    gpuCull.residentVersion = -1;
+    gpuCull.enabled = 1;
+}
+
+/* Gather the tiles of every resident chunk from their impostor texels into the instance SSBO */
+void updateGpuCullTiles()
+{
+    if (gpuCull.residentVersion == streamer->residentVersion)
+    {
+        return;
+    }
+    gpuCull.residentVersion = streamer->residentVersion;
+
+    vector<TileInstance> tiles;
+    for (int i = 0; i < MAX_RESIDENT_CHUNKS; i++)
+    {
+        ChunkSlot &slot = streamer->slots[i];
+        if (slot.state.load(memory_order_acquire) != CHUNK_RESIDENT)
+            continue;
+        for (int cell = 0; cell < CHUNK_BYTES; cell++)
+        {
+            const GLubyte *texel = &slot.texels[cell * 4];
+            if (!texel[3])
+                continue;
+            TileInstance tile;
+            tile.position[0] = (slot.cx * CHUNK_CELLS + cell % CHUNK_CELLS) * 0.5f;
+            tile.position[1] = 0;
+            tile.position[2] = (slot.cz * CHUNK_CELLS + cell / CHUNK_CELLS) * 0.5f;
+            tile.position[3] = 1;
+            for (int j = 0; j < 4; j++)
+                tile.color[j] = texel[j] / 255.0f;
+            tiles.push_back(tile);
+        }
+    }
+    gpuCull.tileCount = tiles.size();
+
+    // Grow the buffers to the next power of two, the visible buffer holds a full range per command
+    if (gpuCull.tileCount > gpuCull.capacity)
+    {
+        gpuCull.capacity = 1024;
+        while (gpuCull.capacity < gpuCull.tileCount)
+            gpuCull.capacity *= 2;
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, gpuCull.tiles);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, gpuCull.capacity * sizeof(TileInstance), NULL, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, gpuCull.visible);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, GPU_CULL_COMMANDS * gpuCull.capacity * sizeof(TileInstance), NULL, GL_DYNAMIC_COPY);
+    }
+    if (!tiles.empty())
+    {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, gpuCull.tiles);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, tiles.size() * sizeof(TileInstance), &tiles[0]);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+/* Cull and draw the resident tiles for one view, passed to executeRenderQueue */
+void drawGpuCulledTiles(const RenderView &view)
+{
+    updateGpuCullTiles();
+    if (!gpuCull.tileCount)
+    {
+        return;
+    }
+    int sample = beginPassTimer(LAYER_TILES);
+
+    // Instance counts start at 0 every frame, the compute shader counts the survivors
+    DrawElementsIndirectCommand commands[GPU_CULL_COMMANDS] = {
+        {(GLuint)gpuCull.boxIndices, 0, 0, 0, 0},
+        {(GLuint)gpuCull.topIndices, 0, (GLuint)gpuCull.boxIndices, 0, (GLuint)gpuCull.capacity}};
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, gpuCull.commands);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(commands), commands, GL_STREAM_DRAW);
+
+    // Frustum planes of VP, in the same space as the tile positions
+    glm::mat4 m = glm::transpose(view.VP);
+    glm::vec4 planes[6] = {m[3] + m[0], m[3] - m[0], m[3] + m[1], m[3] - m[1], m[3] + m[2], m[3] - m[2]};
+    for (int i = 0; i < 6; i++)
+        planes[i] = planes[i] / glm::length(glm::vec3(planes[i].x, planes[i].y, planes[i].z));
+
+    glUseProgram(gpuCull.cullProgram);
+    glUniform4fv(gpuCull.planesID, 6, &planes[0][0]);
+    glUniform4fv(gpuCull.depthRowID, 1, &m[3][0]);
+    glUniform1ui(gpuCull.tileCountID, gpuCull.tileCount);
+    glUniform1f(gpuCull.topDistanceID, gpuCullTopDistance);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, gpuCull.tiles);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, gpuCull.visible);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, gpuCull.commands);
+    glDispatchCompute((gpuCull.tileCount + 63) / 64, 1, 1);
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+
+    glUseProgram(gpuCull.drawProgram);
+    const ProgramUniforms *uniforms = findProgramUniforms(gpuCull.drawProgram);
+    glm::mat4 VP = view.VP, identity(1.0f);
+    glUniformMatrix4fv(uniforms->MatrixID, 1, GL_FALSE, &VP[0][0]);
+    glUniformMatrix4fv(uniforms->ModelID, 1, GL_FALSE, &identity[0][0]);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    glBindVertexArray(gpuCull.meshVAO);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, gpuCull.commands);
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT, 0, GPU_CULL_COMMANDS, 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    // The queue replay tracks its own bindings, leave nothing it could mistake as bound
+    glBindVertexArray(0);
+    glUseProgram(0);
+
+    endPassTimer(sample);
+}
+
+/* Every resident tile as a box into the shadow map, passed to updateShadowMap while the tiles skip the queue
+ * Runs before the frame's cull, so it brings the tile buffer up to date itself */
+void drawGpuCullCasters(const glm::mat4 &lightVP)
+{
+    updateGpuCullTiles();
+    if (!gpuCull.tileCount)
+    {
+        return;
+    }
+    glUseProgram(gpuCull.shadowProgram);
+    glm::mat4 VP = lightVP;
+    glUniformMatrix4fv(gpuCull.shadowMatrixID, 1, GL_FALSE, &VP[0][0]);
+    glBindVertexArray(gpuCull.shadowVAO);
+    glDrawElementsInstanced(GL_TRIANGLES, gpuCull.boxIndices, GL_UNSIGNED_SHORT, 0, gpuCull.tileCount);
+    glBindVertexArray(0);
+    glUseProgram(0);
+}
+
+/* Read back how many tiles the last cull kept, stalls until it ran so only for stats */
+void readGpuCullStats()
+{
+    if (!gpuCull.enabled || !gpuCull.tileCount)
+    {
+        return;
+    }
+    DrawElementsIndirectCommand commands[GPU_CULL_COMMANDS];
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, gpuCull.commands);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(commands), commands);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    gpuCull.visibleBoxes = commands[0].instanceCount;
+    gpuCull.visibleTops = commands[1].instanceCount;
+}
+
+/* Counts of the last readGpuCullStats, also fine once the context is gone */
+void printGpuCullStats()
+{
+    if (!gpuCull.enabled || !gpuCull.tileCount)
+    {
+        return;
+    }
+    int visible = gpuCull.visibleBoxes + gpuCull.visibleTops;
+    printf("gpu cull tiles: %d visible: %d boxes: %u top faces: %u (%.1f%% culled)\n", gpuCull.tileCount, visible,
+           gpuCull.visibleBoxes, gpuCull.visibleTops, 100.0 * (gpuCull.tileCount - visible) / gpuCull.tileCount);
+}
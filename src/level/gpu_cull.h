@@ -0,0 +1,63 @@
+#ifndef LEVEL_GPU_CULL_H
+#define LEVEL_GPU_CULL_H
+
+#include "level/chunks.h"
+
+/****************
+ * GPU culling *
+ ****************/
+
+/* With --gpu-cull on GL 4.3 the tiles of the resident chunks are drawn without the CPU looking at them:
+ * every tile is an instance in an SSBO, Sample_GL_cull.comp tests each against the frustum and appends
+ * the survivors to one of two compacted ranges, boxes up close and top faces further than gpuCullTopDistance,
+ * whose counts it bumps in place in the indirect command buffer drawn with glMultiDrawElementsIndirect
+ * Chunk meshes through the render queue stay the path for GL 3.3 and for split screen
+ * The shadow map covers the block's surroundings rather than the view, so every tile goes into it unculled
+ * The window asks for a 3.3 core context, which Linux drivers (Mesa included, llvmpipe too) answer with the highest
+ * core version they have, so the path is on wherever 4.3 is; macOS stops at 4.1 and always falls back */
+#define GPU_CULL_COMMANDS 2 // box, top face
+
+/* Matches Tile in Sample_GL_cull.comp */
+struct TileInstance
+{
+    GLfloat position[4]; // cell center, w unused
+    GLfloat color[4];
+};
+
+/* Matches the GL DrawElementsIndirectCommand layout */
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+struct GpuCuller
+{
+    int enabled; // --gpu-cull and a GL 4.3 context
+    GLuint cullProgram, drawProgram, shadowProgram;
+    GLint planesID, depthRowID, tileCountID, topDistanceID, shadowMatrixID;
+    GLuint meshVAO, meshVertices, meshIndices;
+    GLuint shadowVAO;                // the same mesh, instanced straight from tiles
+    int boxIndices, topIndices;      // the top face indices follow the box's
+    GLuint tiles, visible, commands; // SSBOs, the last also the indirect buffer
+    int capacity;                    // instances tiles and each half of visible hold
+    int tileCount;
+    long residentVersion;            // of the resident set tiles was built from
+    GLuint visibleBoxes, visibleTops; // instance counts last read back by readGpuCullStats
+};
+
+extern GpuCuller gpuCull;
+
+extern int gpuCullRequested;
+extern float gpuCullTopDistance; // view depth beyond which tiles are drawn as top faces
+
+void initGpuCull();
+void drawGpuCulledTiles(const RenderView &view);
+void drawGpuCullCasters(const glm::mat4 &lightVP);
+void readGpuCullStats();
+void printGpuCullStats();
+
+#endif
@@ -0,0 +1,376 @@
+#include "level/level.h"
+#include "sim/board.h"
+#include "sim/simulation.h"
+#include "sim/snapshot.h"
+#include "render/shadow.h"
+
+/* Everything a level owns, released together by releaseLevelStorage
+ * The names, upload jobs, packed vertices and VAO handles are in the arena,
+ * the GL objects behind the handles are recorded here to be deleted in two calls */
+struct LevelStorage
+{
+    Arena arena;
+    vector<GLuint> vertexArrays;
+    vector<GLuint> buffers;
+};
+
+/* The level in play and the one being loaded */
+LevelStorage levelStorage[2];
+int liveLevel = 0;
+
+/* Owner of level: the worker while PARSING, the GL thread otherwise */
+enum LevelLoadState
+{
+    LEVEL_LOAD_IDLE,
+    LEVEL_LOAD_PARSING,
+    LEVEL_LOAD_UPLOADING,
+    LEVEL_LOAD_FAILED
+};
+
+struct LevelLoader
+{
+    atomic<int> state;
+    string path;
+    LevelDesc level;
+    int queued;      // meshes handed to the upload thread
+    size_t uploaded; // objects with a VAO, in file order
+    double started;       // glfwGetTime() when the load began
+    double parseTime;     // milliseconds on the worker
+    double worstSlice;    // longest upload slice in milliseconds
+    int uploadFrames;
+    long released;        // GL objects of the previous level deleted by the last swap
+} levelLoader;
+
+/* Storage the level being loaded goes into */
+LevelStorage &loadingStorage()
+{
+    return levelStorage[!liveLevel];
+}
+
+/* Delete every GL object of a level and rewind its arena, no matter how many objects it had */
+void releaseLevelStorage(LevelStorage &storage)
+{
+    if (!storage.vertexArrays.empty())
+        glDeleteVertexArrays(storage.vertexArrays.size(), &storage.vertexArrays[0]);
+    if (!storage.buffers.empty())
+        glDeleteBuffers(storage.buffers.size(), &storage.buffers[0]);
+    storage.vertexArrays.clear();
+    storage.buffers.clear();
+    arenaReset(storage.arena);
+}
+
+int colorByName(const string &name, COLOR *c)
+{
+    static const struct
+    {
+        const char *name;
+        COLOR *color;
+    } colors[] = {{"red", &red}, {"green", &green}, {"black", &black}, {"steel", &steel}, {"yellow", &yellow},
+                  {"coolblue", &coolblue}, {"coolgreen", &coolgreen}, {"grey", &grey}, {"teal", &teal}, {"bg", &bg}, {"blue", &blue}};
+    for (size_t i = 0; i < sizeof(colors) / sizeof(colors[0]); i++)
+    {
+        if (name == colors[i].name)
+        {
+            *c = *colors[i].color;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Parse a level file and pack the meshes of its objects into arena, touches no GL or game state */
+int parseLevel(const string &path, LevelDesc &level, Arena &arena)
+{
+    ifstream in(path.c_str());
+    if (!in)
+    {
+        cout << "Cannot open level " << path << endl;
+        return 0;
+    }
+    level.startX = level.startZ = 0;
+    level.goalX = level.goalZ = 0;
+    level.exitX = level.exitZ = 0;
+    level.objects.clear();
+
+    string line;
+    int number = 0;
+    while (getline(in, line))
+    {
+        number++;
+        istringstream fields(line);
+        string type;
+        if (!(fields >> type) || type[0] == '#')
+            continue;
+        int ok;
+        if (type == "start")
+            ok = !!(fields >> level.startX >> level.startZ);
+        else if (type == "goal")
+            ok = !!(fields >> level.goalX >> level.goalZ);
+        else if (type == "exit")
+            ok = !!(fields >> level.exitX >> level.exitZ);
+        else
+        {
+            LevelObject object;
+            string name, color;
+            float x, y, z, width, height, depth;
+            COLOR c;
+            ok = (fields >> name >> x >> y >> z >> width >> height >> depth >> color) && colorByName(color, &c);
+            if (ok)
+            {
+                object.type = arenaString(arena, type);
+                object.sprite = rectangleSprite(arena, name, x, y, z, width, height, depth, 0);
+                object.sprite.color = c;
+                Vertex vertices[BOX_VERTICES];
+                buildRectangle(width, height, depth, vertices);
+                object.upload = newMeshUpload(&arena);
+                packMesh(object.upload->mesh, GL_TRIANGLES, BOX_VERTICES, vertices, 36, boxIndices, rectangleLayout(type), GL_FILL, &arena);
+                level.objects.push_back(object);
+            }
+        }
+        if (!ok)
+        {
+            cout << path << ":" << number << ": cannot parse \"" << line << "\"" << endl;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void levelLoadWorker()
+{
+    double start = glfwGetTime();
+    int ok = parseLevel(levelLoader.path, levelLoader.level, loadingStorage().arena);
+    levelLoader.parseTime = (glfwGetTime() - start) * 1000;
+    levelLoader.state.store(ok ? LEVEL_LOAD_UPLOADING : LEVEL_LOAD_FAILED, memory_order_release);
+}
+
+/* Start loading a level in the background, the current level stays in play until it is swapped in */
+void beginLevelLoad(const string &path)
+{
+    if (levelLoader.state.load(memory_order_acquire) != LEVEL_LOAD_IDLE)
+    {
+        return;
+    }
+    levelLoader.path = path;
+    levelLoader.queued = 0;
+    levelLoader.uploaded = 0;
+    levelLoader.started = glfwGetTime();
+    levelLoader.worstSlice = 0;
+    levelLoader.uploadFrames = 0;
+    levelLoader.state.store(LEVEL_LOAD_PARSING, memory_order_release);
+    thread(levelLoadWorker).detach();
+}
+
+int levelLoading()
+{
+    return levelLoader.state.load(memory_order_acquire) != LEVEL_LOAD_IDLE;
+}
+
+/* Set flag on the cells of the existing sprites of a set */
+void markCells(const SpriteSet &sprites, unsigned char flag)
+{
+    for (int i = 0; i < sprites.count; i++)
+    {
+        const Sprite &sprite = sprites.items[i];
+        if (sprite.exists)
+            addBoardCell(worldToCell(sprite.x), worldToCell(sprite.z), flag);
+    }
+}
+
+/* Rebuild the simulation's lattice from the sprite sets, call after a level changes its tiles */
+void buildBoard()
+{
+    const SpriteSet *layers[] = {&tile, &fragtile, &teles, &toggle, &bridge};
+    int minx = 0, maxx = 0, minz = 0, maxz = 0, first = 1;
+    for (int i = 0; i < 5; i++)
+    {
+        for (int j = 0; j < layers[i]->count; j++)
+        {
+            const Sprite &sprite = layers[i]->items[j];
+            int x = worldToCell(sprite.x), z = worldToCell(sprite.z);
+            if (first || x < minx) minx = x;
+            if (first || x > maxx) maxx = x;
+            if (first || z < minz) minz = z;
+            if (first || z > maxz) maxz = z;
+            first = 0;
+        }
+    }
+    resetBoard(minx, minz, maxx, maxz);
+
+    markCells(tile, CELL_TILE);
+    markCells(fragtile, CELL_FRAGILE);
+    markCells(teles, CELL_TELEPORT);
+    markCells(toggle, CELL_SWITCH);
+    markCells(bridge, CELL_BRIDGE);
+    for (int i = 0; i < toggle.count; i++)
+    {
+        const Sprite &button = toggle.items[i];
+        if (button.exists)
+            addBoardSwitch(worldToCell(button.x), worldToCell(button.z), button.name);
+    }
+    for (int i = 0; i < bridge.count; i++)
+        addBoardBridge(worldToCell(bridge.items[i].x), worldToCell(bridge.items[i].z), bridge.items[i].name);
+    addBoardCell(worldToCell(goalx), worldToCell(goalz), CELL_GOAL);
+}
+
+/* Replace the level in play with the fully uploaded one, the simulation must not be ticking */
+void swapLevel()
+{
+    LevelDesc &level = levelLoader.level;
+    LevelStorage &old = levelStorage[liveLevel];
+    levelLoader.released = old.vertexArrays.size() + old.buffers.size();
+    releaseLevelStorage(old);
+    liveLevel = !liveLevel;
+    clearSprites(tile);
+    clearSprites(fragtile);
+    clearSprites(bridge);
+    clearSprites(toggle);
+    clearSprites(teles);
+    // The sprites go into the arena already holding their names and meshes
+    Arena &arena = levelStorage[liveLevel].arena;
+    for (size_t i = 0; i < level.objects.size(); i++)
+        addSprite(arena, level.objects[i].type, level.objects[i].sprite);
+    level.objects.clear();
+
+    goalx = level.goalX;
+    goalz = level.goalZ;
+    telexitx = level.exitX;
+    telexitz = level.exitZ;
+    placeBlock(level.startX, level.startZ);
+    blockRoll.active = 0;
+    blockTeleport.phase = TELEPORT_NONE;
+    buildBoard();
+    levelGeneration++;
+}
+
+/* Show the switches pressed since the last snapshot: the switch sinks and its bridges come out.
+ * Presses from before the last level swap are ignored, the names belong to the old level.
+ * Returns whether any sprite changed */
+int appliedGeneration = -1;
+int appliedSwitches = 0;
+
+bool applySnapshot(const SimSnapshot &snapshot)
+{
+    if (snapshot.levelGeneration != levelGeneration)
+        return false;
+    if (appliedGeneration != levelGeneration)
+    {
+        appliedGeneration = levelGeneration;
+        appliedSwitches = 0;
+    }
+    int pressedCount = snapshot.pressedSwitches.size();
+    bool changed = appliedSwitches < pressedCount;
+    for (; appliedSwitches < pressedCount; appliedSwitches++)
+    {
+        const string &name = snapshot.pressedSwitches[appliedSwitches];
+        Sprite *part = findSprite(bridge, name.c_str());
+        Sprite *button = findSprite(toggle, name.c_str());
+        if (button && (!part || part->exists == 0))
+            button->y -= 0.1;
+        string names[2] = {name, name + "2"};
+        for (int i = 0; i < 2; i++)
+        {
+            part = findSprite(bridge, names[i].c_str());
+            if (part)
+                part->exists = 1;
+        }
+    }
+    return changed;
+}
+
+/* Once per frame on the GL thread: collect uploaded meshes of the parsed level for at most budget milliseconds,
+ * swapping it in when done */
+void updateLevelLoad(double budget)
+{
+    int state = levelLoader.state.load(memory_order_acquire);
+    if (state == LEVEL_LOAD_FAILED)
+    {
+        cout << "Cannot load " << levelLoader.path << endl;
+        exit(1);
+    }
+    if (state != LEVEL_LOAD_UPLOADING)
+    {
+        return;
+    }
+
+    double slice_start = glfwGetTime();
+    vector<LevelObject> &objects = levelLoader.level.objects;
+    if (!levelLoader.queued)
+    {
+        for (size_t i = 0; i < objects.size(); i++)
+            queueMeshUpload(objects[i].upload);
+        levelLoader.queued = 1;
+    }
+    while (levelLoader.uploaded < objects.size() && (glfwGetTime() - slice_start) * 1000 < budget)
+    {
+        LevelObject &object = objects[levelLoader.uploaded];
+        VAO *vao = collectMeshUpload(object.upload);
+        if (!vao)
+            break;
+        LevelStorage &storage = loadingStorage();
+        storage.vertexArrays.push_back(vao->VertexArrayID);
+        storage.buffers.push_back(vao->VertexBuffer);
+        storage.buffers.push_back(vao->IndexBuffer);
+        object.sprite.object = vao;
+        object.upload = NULL;
+        levelLoader.uploaded++;
+    }
+    levelLoader.uploadFrames++;
+    levelLoader.worstSlice = max(levelLoader.worstSlice, (glfwGetTime() - slice_start) * 1000);
+
+    if (levelLoader.uploaded == objects.size())
+    {
+        const Arena &arena = loadingStorage().arena;
+        printf("loaded %s in %.1f ms: parse %.3f ms, %d upload frames, worst slice %.3f ms\n", levelLoader.path.c_str(),
+               (glfwGetTime() - levelLoader.started) * 1000, levelLoader.parseTime, levelLoader.uploadFrames, levelLoader.worstSlice);
+        printf("  arena: %ld allocations, %ld bytes in %d blocks\n", arena.allocations, arena.bytes, (int)arena.blocks.size());
+        // The only time the simulation waits for the render thread
+        pauseSimulation();
+        swapLevel();
+        publishSnapshot(glfwGetTime(), 0);
+        resumeSimulation();
+        markShadowDirty();
+        printf("  released %ld GL objects of the previous level\n", levelLoader.released);
+        levelLoader.state.store(LEVEL_LOAD_IDLE, memory_order_release);
+    }
+}
+
+/* Allocations of the level in play, its sprites included, and of the objects made at startup */
+void printLevelStats()
+{
+    const LevelStorage &live = levelStorage[liveLevel];
+    int sprites = tile.count + fragtile.count + bridge.count + toggle.count + teles.count;
+    printf("level arena: %ld allocations, %ld bytes in %d blocks for %d sprites, %d VAOs and %d buffers\n",
+           live.arena.allocations, live.arena.bytes, (int)live.arena.blocks.size(), sprites,
+           (int)live.vertexArrays.size(), (int)live.buffers.size());
+    printf("persistent arena: %ld allocations, %ld bytes in %d blocks\n", persistentArena.allocations, persistentArena.bytes,
+           (int)persistentArena.blocks.size());
+}
+
+/* Load a level on the spot, for the first level before the window is shown */
+void loadLevel(const string &path)
+{
+    levelLoader.path = path;
+    levelLoader.queued = 0;
+    levelLoader.uploaded = 0;
+    levelLoader.started = glfwGetTime();
+    levelLoader.worstSlice = 0;
+    levelLoader.uploadFrames = 0;
+    levelLoader.state.store(parseLevel(path, levelLoader.level, loadingStorage().arena) ? LEVEL_LOAD_UPLOADING : LEVEL_LOAD_FAILED);
+    while (levelLoading())
+        updateLevelLoad(1e9);
+}
+
+/* Path of the level file for levelstate */
+string levelPath(int level)
+{
+    stringstream ss;
+    ss << "levels/level" << level + 1 << ".txt";
+    return ss.str();
+}
+
+/* Edit this function according to your assignment */
+void startnextlevel()
+{
+    beginLevelLoad(levelPath(levelstate));
+}
@@ -0,0 +1,47 @@
+#ifndef LEVEL_LEVEL_H
+#define LEVEL_LEVEL_H
+
+#include "common/arena.h"
+#include "level/sprite.h"
+#include "render/upload.h"
+#include "sim/snapshot.h"
+
+/*****************
+ * Level loading *
+ *****************/
+
+/* Levels are text files in levels/, one per line:
+ *   start <cell x> <cell z>, goal <x> <z>, exit <cell x> <cell z> (where the teleporter leads)
+ *   <type> <name> <x> <y> <z> <width> <height> <depth> <color> for each tile, switch, bridge or teleporter
+ * A worker thread parses the file and packs the meshes, the upload thread fills their buffers,
+ * the GL thread makes the VAOs a slice per frame and swaps the whole level in at once between two frames */
+#define LEVEL_UPLOAD_BUDGET 2.0 // milliseconds of VAO creation per frame
+
+struct LevelObject
+{
+    const char *type;
+    Sprite sprite; // object is set once its upload is collected
+    MeshUpload *upload;
+};
+
+struct LevelDesc
+{
+    int startX, startZ;
+    float goalX, goalZ;
+    int exitX, exitZ;
+    vector<LevelObject> objects;
+};
+
+int colorByName(const string &name, COLOR *c);
+int parseLevel(const string &path, LevelDesc &level, Arena &arena);
+void beginLevelLoad(const string &path);
+int levelLoading();
+void updateLevelLoad(double budget);
+void loadLevel(const string &path);
+string levelPath(int level);
+void startnextlevel();
+void buildBoard();
+bool applySnapshot(const SimSnapshot &snapshot);
+void printLevelStats();
+
+#endif
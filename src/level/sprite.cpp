@@ -0,0 +1,169 @@
+#include "level/sprite.h"
+
+SpriteSet cube;
+SpriteSet tile;
+SpriteSet fragtile;
+SpriteSet bridge;
+SpriteSet toggle;
+SpriteSet teles;
+
+VAO *triangle, *rectangle;
+
+// Creates the triangle object used in this sample code
+void createTriangle()
+{
+    /* ONLY vertices between the bounds specified in glm::ortho will be visible on screen */
+
+    /* Define vertex array as used in glBegin (GL_TRIANGLES) */
+    static const GLfloat vertex_buffer_data[] = {
+        0, 0, 0,  // vertex 0
+        -1, 1, 0, // vertex 1
+        -1, 0, 0, // vertex 2
+    };
+
+    static const GLfloat color_buffer_data[] = {
+        1, 0, 0, // color 0
+        1, 0, 0, // color 1
+        1, 0, 0, // color 2
+    };
+
+    // create3DObject creates and returns a handle to a VAO that can be used later
+    triangle = create3DObject(GL_TRIANGLES, 3, vertex_buffer_data, color_buffer_data, GL_FILL);
+}
+
+/* Box of width x height x depth centered on the origin, indexed by boxIndices, its color is given per draw */
+void buildRectangle(float width, float height, float depth, Vertex vertex_data[BOX_VERTICES])
+{
+    buildBox(width / 2, height / 2, depth / 2, vertex_data);
+}
+
+/* Static tiles keep well under 1e-4 of error as normalized shorts, the moving block keeps full floats */
+VertexLayout rectangleLayout(string type)
+{
+    if (type == "cube")
+        return VERTEX_LAYOUT_FLOAT;
+    return VERTEX_LAYOUT_SNORM16;
+}
+
+Sprite rectangleSprite(Arena &arena, string name, float x, float y, float z, float width, float height, float depth, float angle)
+{
+    Sprite elem = {};
+    elem.exists = 1;
+    elem.name = arenaString(arena, name);
+    elem.x = x;
+    elem.y = y;
+    elem.z = z;
+    elem.height = height;
+    elem.width = width;
+    elem.depth = depth;
+    elem.angle = angle;
+    elem.anglex = 0;
+    elem.angley = 0;
+    return elem;
+}
+
+void clearSprites(SpriteSet &set)
+{
+    set.items = NULL;
+    set.byName = NULL;
+    set.count = set.capacity = 0;
+}
+
+/* Position in set.byName of the first sprite whose name is not less than name */
+int spriteRank(const SpriteSet &set, const char *name)
+{
+    int low = 0, high = set.count;
+    while (low < high)
+    {
+        int mid = (low + high) / 2;
+        if (strcmp(set.items[set.byName[mid]].name, name) < 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+/* The sprite called name, NULL if there is none */
+Sprite *findSprite(SpriteSet &set, const char *name)
+{
+    int rank = spriteRank(set, name);
+    if (rank < set.count && !strcmp(set.items[set.byName[rank]].name, name))
+        return &set.items[set.byName[rank]];
+    return NULL;
+}
+
+/* Add elem to set, or replace the sprite of the same name, growing into arena
+ * The arrays are copied into twice the room when full, the old ones stay in the arena until its reset */
+void addSpriteTo(Arena &arena, SpriteSet &set, const Sprite &elem)
+{
+    int rank = spriteRank(set, elem.name);
+    if (rank < set.count && !strcmp(set.items[set.byName[rank]].name, elem.name))
+    {
+        set.items[set.byName[rank]] = elem;
+        return;
+    }
+    if (set.count == set.capacity)
+    {
+        int capacity = max(16, set.capacity * 2);
+        Sprite *items = (Sprite *)arenaAlloc(arena, capacity * sizeof(Sprite), alignof(Sprite));
+        int *byName = (int *)arenaAlloc(arena, capacity * sizeof(int), alignof(int));
+        if (set.count)
+        {
+            memcpy(items, set.items, set.count * sizeof(Sprite));
+            memcpy(byName, set.byName, set.count * sizeof(int));
+        }
+        set.items = items;
+        set.byName = byName;
+        set.capacity = capacity;
+    }
+    memmove(&set.byName[rank + 1], &set.byName[rank], (set.count - rank) * sizeof(int));
+    set.byName[rank] = set.count;
+    set.items[set.count++] = elem;
+}
+
+/* Put a sprite in the set of its type, its name has to live as long as arena */
+void addSprite(Arena &arena, const char *type, Sprite elem)
+{
+    if (!strcmp(type, "cube"))
+    {
+        addSpriteTo(arena, cube, elem);
+    }
+    else if (!strcmp(type, "tile"))
+    {
+        addSpriteTo(arena, tile, elem);
+    }
+    else if (!strcmp(type, "bridge"))
+    {
+        elem.exists = 0;
+        addSpriteTo(arena, bridge, elem);
+    }
+    else if (!strcmp(type, "toggle"))
+    {
+        addSpriteTo(arena, toggle, elem);
+    }
+    else if (!strcmp(type, "fragtile"))
+    {
+        addSpriteTo(arena, fragtile, elem);
+    }
+    else if (!strcmp(type, "teles"))
+    {
+        addSpriteTo(arena, teles, elem);
+    }
+}
+
+// Creates the rectangle object used in this sample code
+void createRectangle(string name, float x, float y, float z, float width, float height, float depth, string type, float angle, COLOR mycolor)
+{
+    // GL3 accepts only Triangles. Quads are not supported
+    // 24 * 12 bytes of vertices + 72 bytes of indices for grid tiles instead of 864 bytes of non indexed positions and colors
+    Vertex vertex_data[BOX_VERTICES];
+    buildRectangle(width, height, depth, vertex_data);
+    rectangle = create3DObject(GL_TRIANGLES, BOX_VERTICES, vertex_data, 36, boxIndices, rectangleLayout(type), GL_FILL);
+
+    // create3DObject creates and returns a handle to a VAO that can be used later
+    Sprite elem = rectangleSprite(persistentArena, name, x, y, z, width, height, depth, angle);
+    elem.color = mycolor;
+    elem.object = rectangle;
+    addSprite(persistentArena, type.c_str(), elem);
+}
@@ -0,0 +1,43 @@
+#ifndef LEVEL_SPRITE_H
+#define LEVEL_SPRITE_H
+
+#include "render/mesh.h"
+
+struct Sprite
+{
+    const char *name; // in the arena of the sprite's level, see arenaString
+    int exists;
+    COLOR color;
+    float x, y, z;
+    float height, width, depth, angle, anglex, angley;
+    VAO *object;
+};
+
+typedef struct Sprite Sprite;
+
+/* Sprites of one kind in an arena, in the order they were added, with their indices sorted by name for findSprite
+ * Nothing is freed one sprite at a time: clearSprites forgets them and the arena goes with its level */
+struct SpriteSet
+{
+    Sprite *items;
+    int *byName;
+    int count, capacity;
+};
+
+extern SpriteSet cube;
+extern SpriteSet tile;
+extern SpriteSet fragtile;
+extern SpriteSet bridge;
+extern SpriteSet toggle;
+extern SpriteSet teles;
+
+void createTriangle();
+void buildRectangle(float width, float height, float depth, Vertex vertex_data[BOX_VERTICES]);
+VertexLayout rectangleLayout(string type);
+Sprite rectangleSprite(Arena &arena, string name, float x, float y, float z, float width, float height, float depth, float angle);
+void clearSprites(SpriteSet &set);
+Sprite *findSprite(SpriteSet &set, const char *name);
+void addSprite(Arena &arena, const char *type, Sprite elem);
+void createRectangle(string name, float x, float y, float z, float width, float height, float depth, string type, float angle, COLOR mycolor);
+
+#endif
@@ -0,0 +1,127 @@
+#include "level/world.h"
+#include "sim/board.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+StreamedWorld world;
+
+/* Map a world file, returns 0 and leaves the built in levels in place on failure */
+int openWorld(const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        cout << "Cannot open world " << path << endl;
+        return 0;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(WorldHeader))
+    {
+        cout << "World " << path << " is too small" << endl;
+        close(fd);
+        return 0;
+    }
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        cout << "Cannot map world " << path << endl;
+        return 0;
+    }
+    WorldHeader header;
+    memcpy(&header, data, sizeof(header));
+    size_t expected = sizeof(WorldHeader) + (size_t)header.chunksX * header.chunksZ * CHUNK_BYTES;
+    if (header.magic != WORLD_MAGIC || header.chunksX <= 0 || header.chunksZ <= 0 || (size_t)st.st_size < expected)
+    {
+        cout << "World " << path << " is not a valid world file" << endl;
+        munmap(data, st.st_size);
+        return 0;
+    }
+    // Only the chunks around the block are touched, don't read ahead the rest of the file
+    madvise(data, st.st_size, MADV_RANDOM);
+    world.data = (const unsigned char *)data;
+    world.size = st.st_size;
+    world.header = header;
+    board.streamedCell = worldCell;
+    return 1;
+}
+
+/* Cell flags of one chunk inside the mapped file */
+const unsigned char *worldChunk(int cx, int cz)
+{
+    return world.data + sizeof(WorldHeader) + ((size_t)cz * world.header.chunksX + cx) * CHUNK_BYTES;
+}
+
+/* Drop the pages under an evicted chunk from the process, rounded out to whole pages
+ * A page holds several chunks and the mapping is a read only file, so neighbours that still need theirs
+ * and the sim's cell lookups simply fault them back in from the page cache */
+void releaseWorldChunk(int cx, int cz)
+{
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t start = worldChunk(cx, cz) - world.data;
+    size_t begin = start / page * page;
+    size_t end = min(world.size, (start + CHUNK_BYTES + page - 1) / page * page);
+    madvise((void *)(world.data + begin), end - begin, MADV_DONTNEED);
+}
+
+unsigned char worldCell(int x, int z)
+{
+    if (x < 0 || z < 0 || x >= world.header.chunksX * CHUNK_CELLS || z >= world.header.chunksZ * CHUNK_CELLS)
+        return 0;
+    return worldChunk(x / CHUNK_CELLS, z / CHUNK_CELLS)[(z % CHUNK_CELLS) * CHUNK_CELLS + x % CHUNK_CELLS];
+}
+
+/* Procedural world for trying out streaming: a winding road three cells wide across the whole width
+ * with some fragile tiles on its edges and random islands around it */
+unsigned char proceduralCell(int x, int z, int width, int depth)
+{
+    unsigned int h = (unsigned int)x * 73856093u ^ (unsigned int)z * 19349663u;
+    h ^= h >> 13;
+    h *= 0x5bd1e995u;
+    h ^= h >> 15;
+    int road = depth / 2 + (int)lroundf(8 * sinf(x * 0.05f));
+    if (x == width - 2 && z == road)
+        return CELL_GOAL;
+    if (x >= 1 && x <= width - 2 && abs(z - road) <= 1)
+        return (z != road && h % 16 == 0) ? CELL_FRAGILE : CELL_TILE;
+    return (h % 10 == 0) ? CELL_TILE : 0;
+}
+
+/* Write a chunksX x chunksZ chunk procedural world to path, one chunk at a time */
+int writeProceduralWorld(const char *path, int chunksX, int chunksZ)
+{
+    if (chunksX <= 0 || chunksZ <= 0)
+    {
+        cout << "A world needs at least one chunk each way" << endl;
+        return 0;
+    }
+    ofstream out(path, ios::binary);
+    if (!out)
+    {
+        cout << "Cannot write world " << path << endl;
+        return 0;
+    }
+    int width = chunksX * CHUNK_CELLS, depth = chunksZ * CHUNK_CELLS;
+    WorldHeader header;
+    header.magic = WORLD_MAGIC;
+    header.chunksX = chunksX;
+    header.chunksZ = chunksZ;
+    header.startX = 1;
+    header.startZ = depth / 2 + (int)lroundf(8 * sinf(0.05f));
+    out.write((const char *)&header, sizeof(header));
+
+    unsigned char cells[CHUNK_BYTES];
+    for (int cz = 0; cz < chunksZ; cz++)
+    {
+        for (int cx = 0; cx < chunksX; cx++)
+        {
+            for (int z = 0; z < CHUNK_CELLS; z++)
+                for (int x = 0; x < CHUNK_CELLS; x++)
+                    cells[z * CHUNK_CELLS + x] = proceduralCell(cx * CHUNK_CELLS + x, cz * CHUNK_CELLS + z, width, depth);
+            out.write((const char *)cells, CHUNK_BYTES);
+        }
+    }
+    return out.good();
+}
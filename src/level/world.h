@@ -0,0 +1,40 @@
+#ifndef LEVEL_WORLD_H
+#define LEVEL_WORLD_H
+
+#include "common/common.h"
+
+/******************
+ * Streamed worlds *
+ ******************/
+
+/* Boards too large to build as sprites are read from a world file of CHUNK_CELLS x CHUNK_CELLS chunks
+ * The file is a WorldHeader followed by chunksX * chunksZ chunks of cell flags (CellFlags), chunk after chunk in rows
+ * and row major inside a chunk, so a chunk is one contiguous CHUNK_BYTES read */
+#define CHUNK_CELLS 16
+#define CHUNK_BYTES (CHUNK_CELLS * CHUNK_CELLS)
+#define WORLD_MAGIC 0x574b4c42 // "BLKW"
+
+struct WorldHeader
+{
+    uint32_t magic;
+    int32_t chunksX, chunksZ;
+    int32_t startX, startZ; // cell the block starts on
+};
+
+struct StreamedWorld
+{
+    const unsigned char *data; // whole file mapped read only, NULL when playing the built in levels
+    size_t size;
+    WorldHeader header;
+};
+
+extern StreamedWorld world;
+
+int openWorld(const char *path);
+const unsigned char *worldChunk(int cx, int cz);
+void releaseWorldChunk(int cx, int cz);
+unsigned char worldCell(int x, int z);
+unsigned char proceduralCell(int x, int z, int width, int depth);
+int writeProceduralWorld(const char *path, int chunksX, int chunksZ);
+
+#endif
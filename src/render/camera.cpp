@@ -0,0 +1,138 @@
+#include "render/camera.h"
+
+GLMatrices Matrices;
+
+int proj_type;
+
+int splitscreen = 0;
+
+/*********************
+ * Camera controller *
+ *********************/
+
+Camera camera = {CAMERA_TOWER, 90, 90, 0.2f};
+
+void setCameraMode(CameraMode mode)
+{
+    if (mode == camera.mode)
+        return;
+    camera.mode = mode;
+    // Views that can be turned start from their default direction, as they always have
+    if (mode == CAMERA_TOWER)
+        camera.orbitAngle = 90;
+    camera.transition = camera.placed;
+}
+
+/* The view keys switch to their mode from the tower view and back to it from any other */
+void toggleCameraMode(CameraMode mode)
+{
+    setCameraMode(camera.mode == CAMERA_TOWER ? mode : CAMERA_TOWER);
+}
+
+/* `o` and `p`, turning where the block looks in block view and around the board otherwise */
+void turnCamera(float degrees)
+{
+    if (camera.mode == CAMERA_BLOCK)
+        camera.lookAngle += degrees;
+    else
+        camera.orbitAngle += degrees;
+}
+
+void setCameraOrbit(float degrees)
+{
+    camera.orbitAngle = degrees;
+}
+
+void zoomCamera(float amount)
+{
+    camera.zoom += amount;
+    camera.dirty = true;
+}
+
+/* Called when a projection changes */
+void markCameraDirty()
+{
+    camera.dirty = true;
+}
+
+void cameraGoal(glm::vec3 block, float blockEyeHeight)
+{
+    float orbit = camera.orbitAngle * M_PI / 180;
+    float look = camera.lookAngle * M_PI / 180;
+    switch (camera.mode)
+    {
+    case CAMERA_TOWER:
+        camera.goalEye = glm::vec3(5 * cos(orbit), 4, 5 * sin(orbit));
+        camera.goalTarget = glm::vec3(0, 0, 0);
+        break;
+    case CAMERA_TOP:
+        // Off center target so lookAt has a direction for up
+        camera.goalEye = glm::vec3(0, 6, 0);
+        camera.goalTarget = glm::vec3(1, -0.5, 0);
+        break;
+    case CAMERA_BLOCK:
+        camera.goalEye = glm::vec3(block.x, block.y + blockEyeHeight, block.z);
+        camera.goalTarget = glm::vec3(block.x + cos(look), 0, block.z + sin(look));
+        break;
+    case CAMERA_FOLLOW:
+        camera.goalEye = glm::vec3(block.x - 3, 2, block.z);
+        camera.goalTarget = glm::vec3(block.x, 1.7, block.z);
+        break;
+    }
+}
+
+float cameraDistance(glm::vec3 a, glm::vec3 b)
+{
+    glm::vec3 d = a - b;
+    return sqrtf(d.x * d.x + d.y * d.y + d.z * d.z);
+}
+
+/* Move the camera for this frame and rebuild its matrices if anything moved */
+void updateCamera(double now, glm::vec3 block, float blockEyeHeight)
+{
+    float dt = camera.placed ? min(now - camera.lastUpdate, 0.1) : 0;
+    camera.lastUpdate = now;
+    camera.frames++;
+    cameraGoal(block, blockEyeHeight);
+
+    glm::vec3 eye = camera.goalEye, target = camera.goalTarget;
+    if (camera.transition)
+    {
+        float t = 1 - exp(-CAMERA_DAMPING * dt);
+        eye = camera.eye + (camera.goalEye - camera.eye) * t;
+        target = camera.target + (camera.goalTarget - camera.target) * t;
+        if (cameraDistance(eye, camera.goalEye) < CAMERA_SETTLED && cameraDistance(target, camera.goalTarget) < CAMERA_SETTLED)
+        {
+            eye = camera.goalEye;
+            target = camera.goalTarget;
+            camera.transition = false;
+        }
+    }
+    if (!camera.placed || eye != camera.eye || target != camera.target)
+    {
+        camera.eye = eye;
+        camera.target = target;
+        camera.placed = true;
+        camera.dirty = true;
+    }
+    if (!camera.dirty)
+        return;
+
+    camera.view = glm::lookAt(camera.eye, camera.target, glm::vec3(0, 1, 0));
+    glm::mat4 viewZoom = camera.view * glm::scale(glm::vec3(exp(camera.zoom)));
+    camera.VP[CAMERA_ORTHO] = Matrices.projectionO * viewZoom;
+    camera.VP[CAMERA_PERSPECTIVE] = Matrices.projectionP * viewZoom;
+    camera.VP[CAMERA_PERSPECTIVE_SPLIT] = Matrices.projectionPSplit * viewZoom;
+    camera.dirty = false;
+    camera.viewUpdates++;
+}
+
+const glm::mat4 &cameraViewProjection(CameraProjection projection)
+{
+    return camera.VP[projection];
+}
+
+void printCameraStats()
+{
+    printf("camera: view rebuilt in %ld of %ld frames\n", camera.viewUpdates, camera.frames);
+}
@@ -0,0 +1,79 @@
+#ifndef RENDER_CAMERA_H
+#define RENDER_CAMERA_H
+
+#include "common/common.h"
+
+struct GLMatrices
+{
+    glm::mat4 projectionO, projectionP;
+    glm::mat4 projectionPSplit; // perspective for half the window width
+    glm::mat4 model;
+    GLuint MatrixID;
+    GLuint ModelID;
+};
+
+extern GLMatrices Matrices;
+
+extern int proj_type;
+
+extern int splitscreen;
+
+/*********************
+ * Camera controller *
+ *********************/
+
+enum CameraMode
+{
+    CAMERA_TOWER = 0, // orbits the board from above, `o`, `p` and dragging turn it
+    CAMERA_TOP,       // looks straight down on the board
+    CAMERA_BLOCK,     // inside the block, `o` and `p` turn where it looks
+    CAMERA_FOLLOW,    // behind the block, following it around the map
+};
+
+/* Switching modes flies the eye and target to the new mode's with an exponential ease,
+ * once there they track it exactly so the block view stays inside the block */
+#define CAMERA_DAMPING 8.0f     // per second, the remaining distance shrinks by e every 1/8 s
+#define CAMERA_SETTLED 0.001f   // distance at which a transition snaps to its goal
+
+/* Which projection a cached view projection uses */
+enum CameraProjection
+{
+    CAMERA_ORTHO = 0,
+    CAMERA_PERSPECTIVE,
+    CAMERA_PERSPECTIVE_SPLIT,
+    NUM_CAMERA_PROJECTIONS
+};
+
+struct Camera
+{
+    CameraMode mode;
+    float orbitAngle; // degrees around the board in tower view
+    float lookAngle;  // degrees around the vertical in block view
+    float zoom;       // log scale, changed by the scroll wheel
+
+    glm::vec3 eye, target;         // where the camera is this frame
+    glm::vec3 goalEye, goalTarget; // where the current mode wants it
+    bool placed;                   // eye and target hold a position, the first update snaps
+    bool transition;               // easing towards the goal after a mode change
+    double lastUpdate;
+
+    // The view and view projections only change when the eye, target, zoom or a projection does
+    bool dirty;
+    glm::mat4 view;
+    glm::mat4 VP[NUM_CAMERA_PROJECTIONS];
+    long frames, viewUpdates;
+};
+
+extern Camera camera;
+
+void setCameraMode(CameraMode mode);
+void toggleCameraMode(CameraMode mode);
+void turnCamera(float degrees);
+void setCameraOrbit(float degrees);
+void zoomCamera(float amount);
+void markCameraDirty();
+void updateCamera(double now, glm::vec3 block, float blockEyeHeight);
+const glm::mat4 &cameraViewProjection(CameraProjection projection);
+void printCameraStats();
+
+#endif
@@ -0,0 +1,77 @@
+#include "render/lighting.h"
+
+Lighting lighting;
+
+/* Create the buffer with the default light, coming from above and in front of the board */
+void initLighting()
+{
+    glGenBuffers(1, &lighting.buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, lighting.buffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(LightingBlock), NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, LIGHTING_BINDING, lighting.buffer);
+
+    lighting.block.specular = glm::vec4(0.25f, 0.25f, 0.25f, 32);
+    lighting.block.eye = glm::vec4(0, 0, 0, 1);
+    setLight(glm::vec3(2, 4, 3), glm::vec3(0.45f), glm::vec3(0.55f));
+}
+
+/* Point the program's Lighting block at the shared buffer and its shadow sampler at the shadow map's unit,
+ * GL 3.3 has no binding layout qualifier */
+void bindLightingBlock(GLuint program)
+{
+    if (!program)
+        return;
+    GLuint index = glGetUniformBlockIndex(program, "Lighting");
+    if (index != GL_INVALID_INDEX)
+        glUniformBlockBinding(program, index, LIGHTING_BINDING);
+    GLint sampler = glGetUniformLocation(program, "shadowMap");
+    if (sampler >= 0)
+    {
+        glUseProgram(program);
+        glUniform1i(sampler, SHADOW_TEXTURE_UNIT);
+    }
+}
+
+void setLight(const glm::vec3 &direction, const glm::vec3 &color, const glm::vec3 &ambient)
+{
+    lighting.block.direction = glm::vec4(glm::normalize(direction), 0);
+    lighting.block.color = glm::vec4(color, 1);
+    lighting.block.ambient = glm::vec4(ambient, 1);
+    lighting.dirty = true;
+}
+
+/* Light space the shadow map was last drawn in, the lit shaders skip the lookup until this is called */
+void setShadow(const glm::mat4 &matrix, float texel, float bias)
+{
+    glm::vec4 params(1, texel, bias, 0);
+    if (memcmp(&lighting.block.shadowMatrix, &matrix, sizeof(matrix)) == 0 && memcmp(&lighting.block.shadow, &params, sizeof(params)) == 0)
+        return;
+    lighting.block.shadowMatrix = matrix;
+    lighting.block.shadow = params;
+    lighting.dirty = true;
+}
+
+/* Once per frame before the scene is drawn */
+void updateLighting(const glm::vec3 &eye)
+{
+    lighting.frames++;
+    const glm::vec4 &last = lighting.block.eye;
+    if (last.x != eye.x || last.y != eye.y || last.z != eye.z)
+    {
+        lighting.block.eye = glm::vec4(eye, 1);
+        lighting.dirty = true;
+    }
+    if (!lighting.dirty)
+        return;
+    glBindBuffer(GL_UNIFORM_BUFFER, lighting.buffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(LightingBlock), &lighting.block);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    lighting.dirty = false;
+    lighting.uploads++;
+}
+
+void printLightingStats()
+{
+    printf("lighting: buffer rewritten in %d of %d frames\n", lighting.uploads, lighting.frames);
+}
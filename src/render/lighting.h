@@ -0,0 +1,45 @@
+#ifndef RENDER_LIGHTING_H
+#define RENDER_LIGHTING_H
+
+#include "common/common.h"
+
+/************
+ * Lighting *
+ ************/
+
+/* One directional light and an ambient term shared by every lit program through a uniform buffer
+ * The lit shaders shade per pixel with Blinn-Phong, the buffer is only rewritten when the light or the eye moves */
+#define LIGHTING_BINDING 0 // uniform buffer binding point of the Lighting block
+#define SHADOW_TEXTURE_UNIT 1 // the shadow map stays bound here, unit 0 is for per draw textures
+
+/* std140 layout of the Lighting block in Sample_GL.frag and Sample_GL_impostor.frag */
+struct LightingBlock
+{
+    glm::vec4 direction; // towards the light, normalized
+    glm::vec4 color;     // diffuse and specular intensity of the light
+    glm::vec4 ambient;
+    glm::vec4 eye;       // world space camera position for the half vector
+    glm::vec4 specular;  // rgb strength, w the shininess exponent
+    glm::mat4 shadowMatrix; // world to light clip space
+    glm::vec4 shadow;       // x 1 when there is a shadow map, y its texel size, z the depth bias
+};
+
+struct Lighting
+{
+    GLuint buffer;
+    LightingBlock block;
+    bool dirty;  // block differs from the buffer
+    int uploads; // times the buffer was rewritten
+    int frames;
+};
+
+extern Lighting lighting;
+
+void initLighting();
+void bindLightingBlock(GLuint program);
+void setLight(const glm::vec3 &direction, const glm::vec3 &color, const glm::vec3 &ambient);
+void setShadow(const glm::mat4 &matrix, float texel, float bias);
+void updateLighting(const glm::vec3 &eye);
+void printLightingStats();
+
+#endif
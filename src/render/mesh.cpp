@@ -0,0 +1,307 @@
+#include "render/mesh.h"
+
+const GLushort boxIndices[36] = {
+    0, 1, 2, 0, 2, 3,       // -x
+    4, 5, 6, 4, 6, 7,       // +x
+    8, 9, 10, 8, 10, 11,    // -y
+    12, 13, 14, 12, 14, 15, // +y
+    16, 17, 18, 16, 18, 19, // -z
+    20, 21, 22, 20, 22, 23  // +z
+};
+
+/* Faces of a box centered on the origin in boxIndices order, counter clockwise seen from outside
+ * Each face has its own 4 vertices so its normal stays flat across it */
+void buildBox(float halfX, float halfY, float halfZ, Vertex vertex_data[BOX_VERTICES])
+{
+    float half[3] = {halfX, halfY, halfZ};
+    for (int face = 0; face < 6; face++)
+    {
+        int axis = face / 2;
+        float sign = (face & 1) ? 1 : -1;
+        // The in plane axes are swapped on the negative faces to keep them counter clockwise from outside
+        int u = (axis + 1) % 3, v = (axis + 2) % 3;
+        if (sign < 0)
+            swap(u, v);
+        for (int i = 0; i < 4; i++)
+        {
+            Vertex &vertex = vertex_data[face * 4 + i];
+            vertex.position[axis] = sign * half[axis];
+            vertex.position[u] = (i == 1 || i == 2) ? half[u] : -half[u];
+            vertex.position[v] = (i >= 2) ? half[v] : -half[v];
+            vertex.normal[axis] = sign;
+            vertex.normal[u] = 0;
+            vertex.normal[v] = 0;
+        }
+    }
+}
+
+/* Generate VAO, VBOs and return VAO handle */
+struct VAO *create3DObject(GLenum primitive_mode, int numVertices, const GLfloat *vertex_buffer_data, const GLfloat *color_buffer_data, GLenum fill_mode)
+{
+    struct VAO *vao = new struct VAO;
+    vao->PrimitiveMode = primitive_mode;
+    vao->NumVertices = numVertices;
+    vao->FillMode = fill_mode;
+    vao->IndexBuffer = 0;
+    vao->NumIndices = 0;
+    vao->IndexType = GL_UNSIGNED_SHORT;
+    vao->Layout = VERTEX_LAYOUT_FLOAT;
+    vao->PositionScale = 1;
+    vao->VertexColors = true;
+
+    // Create Vertex Array Object
+    // Should be done after CreateWindow and before any other GL calls
+    glGenVertexArrays(1, &(vao->VertexArrayID)); // VAO
+    glGenBuffers(1, &(vao->VertexBuffer));       // VBO - vertices
+    glGenBuffers(1, &(vao->ColorBuffer));        // VBO - colors
+
+    glBindVertexArray(vao->VertexArrayID);                                                                // Bind the VAO
+    glBindBuffer(GL_ARRAY_BUFFER, vao->VertexBuffer);                                                     // Bind the VBO vertices
+    glBufferData(GL_ARRAY_BUFFER, 3 * numVertices * sizeof(GLfloat), vertex_buffer_data, GL_STATIC_DRAW); // Copy the vertices into VBO
+    glVertexAttribPointer(
+        0,        // attribute 0. Vertices
+        3,        // size (x,y,z)
+        GL_FLOAT, // type
+        GL_FALSE, // normalized?
+        0,        // stride
+        (void *)0 // array buffer offset
+        );
+    glEnableVertexAttribArray(0); // Recorded in the VAO, no need to enable it again at draw time
+
+    glBindBuffer(GL_ARRAY_BUFFER, vao->ColorBuffer);                                                     // Bind the VBO colors
+    glBufferData(GL_ARRAY_BUFFER, 3 * numVertices * sizeof(GLfloat), color_buffer_data, GL_STATIC_DRAW); // Copy the vertex colors
+    glVertexAttribPointer(
+        1,        // attribute 1. Color
+        3,        // size (r,g,b)
+        GL_FLOAT, // type
+        GL_FALSE, // normalized?
+        0,        // stride
+        (void *)0 // array buffer offset
+        );
+    glEnableVertexAttribArray(1);
+
+    return vao;
+}
+
+/* Generate VAO, VBOs and return VAO handle - Common Color for all vertices */
+struct VAO *create3DObject(GLenum primitive_mode, int numVertices, const GLfloat *vertex_buffer_data, const GLfloat red, const GLfloat green, const GLfloat blue, GLenum fill_mode)
+{
+    GLfloat *color_buffer_data = new GLfloat[3 * numVertices];
+    for (int i = 0; i < numVertices; i++)
+    {
+        color_buffer_data[3 * i] = red;
+        color_buffer_data[3 * i + 1] = green;
+        color_buffer_data[3 * i + 2] = blue;
+    }
+
+    struct VAO *vao = create3DObject(primitive_mode, numVertices, vertex_buffer_data, color_buffer_data, fill_mode);
+    // glBufferData has copied the colors
+    delete[] color_buffer_data;
+    return vao;
+}
+
+const VertexLayoutDesc vertexLayouts[] = {
+    {GL_FLOAT, 3, GL_FALSE, 3 * sizeof(GLfloat)},     // VERTEX_LAYOUT_FLOAT
+    {GL_HALF_FLOAT, 4, GL_FALSE, 4 * sizeof(GLshort)}, // VERTEX_LAYOUT_HALF
+    {GL_SHORT, 4, GL_TRUE, 4 * sizeof(GLshort)},       // VERTEX_LAYOUT_SNORM16
+};
+
+/* Size in bytes of one vertex in the given layout */
+int vertexStride(VertexLayout layout, bool vertex_colors)
+{
+    return vertexLayouts[layout].positionBytes + 4 + (vertex_colors ? 4 : 0);
+}
+
+GLshort packSnorm16(float value)
+{
+    if (value > 1)
+        value = 1;
+    if (value < -1)
+        value = -1;
+    return (GLshort)roundf(value * 32767);
+}
+
+/* Pack authored vertices and indices into arena, or into the mesh itself without one; touches no GL state
+ * The vertex colors are dropped unless vertex_colors is set */
+void packMesh(PackedMesh &mesh, GLenum primitive_mode, int numVertices, const Vertex *vertex_data, int numIndices, const GLushort *index_data, VertexLayout layout, GLenum fill_mode, Arena *arena, bool vertex_colors)
+{
+    mesh.PrimitiveMode = primitive_mode;
+    mesh.NumVertices = numVertices;
+    mesh.NumIndices = numIndices;
+    mesh.FillMode = fill_mode;
+    mesh.Layout = layout;
+    mesh.PositionScale = 1;
+    mesh.VertexColors = vertex_colors;
+
+    const VertexLayoutDesc &desc = vertexLayouts[layout];
+    int stride = vertexStride(layout, vertex_colors);
+
+    if (layout == VERTEX_LAYOUT_SNORM16)
+    {
+        // Normalized shorts cover [-1, 1], scale by the largest coordinate
+        float extent = 0;
+        for (int i = 0; i < numVertices; i++)
+            for (int j = 0; j < 3; j++)
+                extent = max(extent, fabsf(vertex_data[i].position[j]));
+        if (extent > 0)
+            mesh.PositionScale = extent;
+    }
+
+    // Small meshes index with bytes
+    mesh.IndexType = (numVertices <= 256) ? GL_UNSIGNED_BYTE : GL_UNSIGNED_SHORT;
+    mesh.vertexBytes = numVertices * stride;
+    mesh.indexBytes = numIndices * (mesh.IndexType == GL_UNSIGNED_BYTE ? sizeof(GLubyte) : sizeof(GLushort));
+    if (arena)
+    {
+        mesh.vertices = (GLubyte *)arenaAlloc(*arena, mesh.vertexBytes);
+        mesh.indices = (GLubyte *)arenaAlloc(*arena, mesh.indexBytes);
+    }
+    else
+    {
+        mesh.storage.resize(mesh.vertexBytes + mesh.indexBytes);
+        mesh.vertices = &mesh.storage[0];
+        mesh.indices = &mesh.storage[mesh.vertexBytes];
+    }
+
+    // Pack the vertices into the GPU layout
+    for (int i = 0; i < numVertices; i++)
+    {
+        GLubyte *out = &mesh.vertices[i * stride];
+        const Vertex &v = vertex_data[i];
+        if (layout == VERTEX_LAYOUT_FLOAT)
+        {
+            memcpy(out, v.position, 3 * sizeof(GLfloat));
+        }
+        else
+        {
+            GLushort position[4];
+            for (int j = 0; j < 3; j++)
+            {
+                if (layout == VERTEX_LAYOUT_HALF)
+                    position[j] = glm::packHalf1x16(v.position[j]);
+                else
+                    position[j] = (GLushort)packSnorm16(v.position[j] / mesh.PositionScale);
+            }
+            position[3] = (layout == VERTEX_LAYOUT_HALF) ? glm::packHalf1x16(1.0f) : (GLushort)packSnorm16(1.0f);
+            memcpy(out, position, sizeof(position));
+        }
+        out += desc.positionBytes;
+        for (int j = 0; j < 3; j++)
+            out[j] = (GLubyte)(GLbyte)roundf(v.normal[j] * 127);
+        out[3] = 0;
+        if (vertex_colors)
+            memcpy(out + 4, v.color, 4);
+    }
+
+    if (mesh.IndexType == GL_UNSIGNED_BYTE)
+    {
+        for (int i = 0; i < numIndices; i++)
+            mesh.indices[i] = (GLubyte)index_data[i];
+    }
+    else
+    {
+        memcpy(mesh.indices, index_data, mesh.indexBytes);
+    }
+}
+
+/* Create and fill the vertex and index buffers of a packed mesh
+ * Both go through GL_COPY_WRITE_BUFFER so no VAO needs to be bound, as on the upload thread */
+void uploadMeshBuffers(const PackedMesh &mesh, GLuint *vertexBuffer, GLuint *indexBuffer)
+{
+    glGenBuffers(1, vertexBuffer); // VBO - interleaved vertices
+    glGenBuffers(1, indexBuffer);  // EBO - indices
+    glBindBuffer(GL_COPY_WRITE_BUFFER, *vertexBuffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, mesh.vertexBytes, mesh.vertices, GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, *indexBuffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, mesh.indexBytes, mesh.indices, GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+/* Wrap uploaded buffers in a VAO, VAOs are not shared between contexts so this runs on the GL thread
+ * The handle comes from arena when given, its GL objects are then released with the arena's owner */
+struct VAO *createMeshVAO(const PackedMesh &mesh, GLuint vertexBuffer, GLuint indexBuffer, Arena *arena)
+{
+    struct VAO *vao = arena ? (struct VAO *)arenaAlloc(*arena, sizeof(struct VAO)) : new struct VAO;
+    vao->PrimitiveMode = mesh.PrimitiveMode;
+    vao->NumVertices = mesh.NumVertices;
+    vao->NumIndices = mesh.NumIndices;
+    vao->FillMode = mesh.FillMode;
+    vao->IndexType = mesh.IndexType;
+    vao->ColorBuffer = 0;
+    vao->VertexBuffer = vertexBuffer;
+    vao->IndexBuffer = indexBuffer;
+    vao->Layout = mesh.Layout;
+    vao->PositionScale = mesh.PositionScale;
+    vao->VertexColors = mesh.VertexColors;
+
+    const VertexLayoutDesc &desc = vertexLayouts[mesh.Layout];
+    int stride = vertexStride(mesh.Layout, mesh.VertexColors);
+
+    glGenVertexArrays(1, &(vao->VertexArrayID)); // VAO
+    glBindVertexArray(vao->VertexArrayID);
+    glBindBuffer(GL_ARRAY_BUFFER, vao->VertexBuffer);
+
+    // attribute 0. Vertices
+    glVertexAttribPointer(0, desc.positionSize, desc.positionType, desc.positionNormalized, stride, (void *)0);
+    glEnableVertexAttribArray(0);
+    // attribute 1. Color, normalized from 0-255 to 0-1, left disabled to take the per draw color
+    if (mesh.VertexColors)
+    {
+        glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void *)(size_t)(desc.positionBytes + 4));
+        glEnableVertexAttribArray(1);
+    }
+    // attribute 2. Normal, normalized from -127-127 to -1-1
+    glVertexAttribPointer(2, 3, GL_BYTE, GL_TRUE, stride, (void *)(size_t)desc.positionBytes);
+    glEnableVertexAttribArray(2);
+
+    // The element buffer binding is part of the VAO state
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vao->IndexBuffer);
+
+    return vao;
+}
+
+/* Generate VAO, interleaved VBO and element buffer and return VAO handle */
+/* Position, normal and any color share one buffer so a vertex is fetched with a single read */
+struct VAO *create3DObject(GLenum primitive_mode, int numVertices, const Vertex *vertex_data, int numIndices, const GLushort *index_data, VertexLayout layout, GLenum fill_mode)
+{
+    PackedMesh mesh;
+    packMesh(mesh, primitive_mode, numVertices, vertex_data, numIndices, index_data, layout, fill_mode);
+    GLuint vertexBuffer, indexBuffer;
+    uploadMeshBuffers(mesh, &vertexBuffer, &indexBuffer);
+    return createMeshVAO(mesh, vertexBuffer, indexBuffer);
+}
+
+/* Release the GL objects of a VAO made by create3DObject and the handle itself */
+void destroy3DObject(struct VAO *vao)
+{
+    glDeleteVertexArrays(1, &vao->VertexArrayID);
+    glDeleteBuffers(1, &vao->VertexBuffer);
+    if (vao->ColorBuffer)
+        glDeleteBuffers(1, &vao->ColorBuffer);
+    if (vao->IndexBuffer)
+        glDeleteBuffers(1, &vao->IndexBuffer);
+    delete vao;
+}
+
+/* Issue the draw call for the currently bound VAO */
+void drawGeometry(struct VAO *vao)
+{
+    if (vao->IndexBuffer)
+        glDrawElements(vao->PrimitiveMode, vao->NumIndices, vao->IndexType, (void *)0);
+    else
+        glDrawArrays(vao->PrimitiveMode, 0, vao->NumVertices); // Starting from vertex 0; 3 vertices total -> 1 triangle
+}
+
+/* Render the VBOs handled by VAO */
+/* Immediate path - prefer submit3DObject so the draw is state sorted */
+void draw3DObject(struct VAO *vao)
+{
+    // Change the Fill Mode for this object
+    glPolygonMode(GL_FRONT_AND_BACK, vao->FillMode);
+
+    // Bind the VAO to use, the attribute arrays and VBOs are part of its state
+    glBindVertexArray(vao->VertexArrayID);
+
+    // Draw the geometry !
+    drawGeometry(vao);
+}
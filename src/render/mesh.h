@@ -0,0 +1,94 @@
+#ifndef RENDER_MESH_H
+#define RENDER_MESH_H
+
+#include "common/arena.h"
+#include "common/color.h"
+
+/* GPU side vertex formats of the indexed meshes
+ * Every layout is interleaved: position | normal (4 x GL_BYTE) [| color (4 x GL_UNSIGNED_BYTE)]
+ * FLOAT   - 3 x GL_FLOAT positions, 16 bytes per vertex
+ * HALF    - 4 x GL_HALF_FLOAT positions, 12 bytes per vertex
+ * SNORM16 - 4 x normalized GL_SHORT positions divided by PositionScale, 12 bytes per vertex
+ * Only meshes merging differently colored parts keep the color, 4 more bytes per vertex; the others
+ * are colored per draw through the current value of the color attribute, see submit3DObject */
+enum VertexLayout
+{
+    VERTEX_LAYOUT_FLOAT = 0,
+    VERTEX_LAYOUT_HALF,
+    VERTEX_LAYOUT_SNORM16
+};
+
+struct VAO
+{
+    GLuint VertexArrayID;
+    GLuint VertexBuffer;
+    GLuint ColorBuffer;
+    GLuint IndexBuffer; // 0 for non indexed geometry
+
+    GLenum PrimitiveMode;
+    GLenum FillMode;
+    int NumVertices;
+    int NumIndices;
+    GLenum IndexType;
+
+    VertexLayout Layout;
+    float PositionScale; // model space size of a unit SNORM16 position, 1 otherwise
+    bool VertexColors;   // the color attribute is an array, otherwise it is set per draw
+};
+
+typedef struct VAO VAO;
+
+/* 4 vertices for each face of a box, indexed by 36 indices */
+#define BOX_VERTICES 24
+extern const GLushort boxIndices[36];
+
+/* CPU side vertex the indexed meshes are authored in, packed to a VertexLayout on upload */
+struct Vertex
+{
+    GLfloat position[3];
+    GLfloat normal[3];
+    GLubyte color[4]; // RGBA8, only packed for meshes with vertex colors
+};
+
+struct VertexLayoutDesc
+{
+    GLenum positionType;
+    GLint positionSize;
+    GLboolean positionNormalized;
+    int positionBytes;
+};
+
+extern const VertexLayoutDesc vertexLayouts[];
+
+/* Vertices and indices packed to their GPU layout, made on any thread and uploaded by any thread sharing the context */
+struct PackedMesh
+{
+    GLenum PrimitiveMode;
+    GLenum FillMode;
+    int NumVertices;
+    int NumIndices;
+    GLenum IndexType;
+    VertexLayout Layout;
+    float PositionScale;
+    bool VertexColors;
+    GLubyte *vertices;
+    size_t vertexBytes;
+    GLubyte *indices;
+    size_t indexBytes;
+    vector<GLubyte> storage; // backs vertices and indices unless they are in an arena
+};
+
+struct VAO *create3DObject(GLenum primitive_mode, int numVertices, const GLfloat *vertex_buffer_data, const GLfloat *color_buffer_data, GLenum fill_mode = GL_FILL);
+struct VAO *create3DObject(GLenum primitive_mode, int numVertices, const GLfloat *vertex_buffer_data, const GLfloat red, const GLfloat green, const GLfloat blue, GLenum fill_mode = GL_FILL);
+void buildBox(float halfX, float halfY, float halfZ, Vertex vertex_data[BOX_VERTICES]);
+int vertexStride(VertexLayout layout, bool vertex_colors);
+GLshort packSnorm16(float value);
+void packMesh(PackedMesh &mesh, GLenum primitive_mode, int numVertices, const Vertex *vertex_data, int numIndices, const GLushort *index_data, VertexLayout layout = VERTEX_LAYOUT_FLOAT, GLenum fill_mode = GL_FILL, Arena *arena = NULL, bool vertex_colors = false);
+void uploadMeshBuffers(const PackedMesh &mesh, GLuint *vertexBuffer, GLuint *indexBuffer);
+struct VAO *createMeshVAO(const PackedMesh &mesh, GLuint vertexBuffer, GLuint indexBuffer, Arena *arena = NULL);
+struct VAO *create3DObject(GLenum primitive_mode, int numVertices, const Vertex *vertex_data, int numIndices, const GLushort *index_data, VertexLayout layout = VERTEX_LAYOUT_FLOAT, GLenum fill_mode = GL_FILL);
+void destroy3DObject(struct VAO *vao);
+void drawGeometry(struct VAO *vao);
+void draw3DObject(struct VAO *vao);
+
+#endif
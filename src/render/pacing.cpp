@@ -0,0 +1,115 @@
+#include "render/pacing.h"
+#include <chrono>
+
+FramePacing pacing = {PACING_VSYNC};
+
+const char *pacingModeNames[] = {"vsync", "adaptive", "uncapped", "capped"};
+
+/* `vsync`, `adaptive`, `uncapped` or a frame rate to cap at */
+bool parsePacingMode(const char *name)
+{
+    for (int mode = PACING_VSYNC; mode <= PACING_UNCAPPED; mode++)
+    {
+        if (!strcmp(name, pacingModeNames[mode]))
+        {
+            pacing.mode = (PacingMode)mode;
+            pacing.chosen = true;
+            return true;
+        }
+    }
+    double hz = atof(name);
+    if (hz <= 0)
+    {
+        fprintf(stderr, "--pacing takes vsync, adaptive, uncapped or a frame rate, not %s\n", name);
+        return false;
+    }
+    pacing.mode = PACING_CAPPED;
+    pacing.capHz = hz;
+    pacing.chosen = true;
+    return true;
+}
+
+/* Needs the window's context to be current */
+void startFramePacing()
+{
+    GLFWmonitor *monitor = glfwGetPrimaryMonitor();
+    const GLFWvidmode *videoMode = monitor ? glfwGetVideoMode(monitor) : NULL;
+    pacing.refreshHz = (videoMode && videoMode->refreshRate > 0) ? videoMode->refreshRate : 60;
+
+    if (pacing.mode == PACING_ADAPTIVE &&
+        !glfwExtensionSupported("WGL_EXT_swap_control_tear") && !glfwExtensionSupported("GLX_EXT_swap_control_tear"))
+    {
+        printf("pacing: no swap_control_tear, adaptive falls back to vsync\n");
+        pacing.mode = PACING_VSYNC;
+    }
+    switch (pacing.mode)
+    {
+    case PACING_VSYNC:
+        glfwSwapInterval(1);
+        pacing.budget = 1 / pacing.refreshHz;
+        break;
+    case PACING_ADAPTIVE:
+        glfwSwapInterval(-1);
+        pacing.budget = 1 / pacing.refreshHz;
+        break;
+    case PACING_UNCAPPED:
+        glfwSwapInterval(0);
+        pacing.budget = 0;
+        break;
+    case PACING_CAPPED:
+        glfwSwapInterval(0);
+        pacing.budget = 1 / pacing.capHz;
+        break;
+    }
+    pacing.deadline = pacing.lastFrame = glfwGetTime();
+}
+
+void sleepUntil(double deadline)
+{
+    double remaining = deadline - glfwGetTime();
+    if (remaining > PACING_SPIN)
+        this_thread::sleep_for(chrono::duration<double>(remaining - PACING_SPIN));
+    while (glfwGetTime() < deadline)
+        ;
+}
+
+void recordFrameTime(double ms)
+{
+    pacing.frames++;
+    double delta = ms - pacing.mean;
+    pacing.mean += delta / pacing.frames;
+    pacing.m2 += delta * (ms - pacing.mean);
+    pacing.shortest = pacing.frames == 1 ? ms : min(pacing.shortest, ms);
+    pacing.longest = max(pacing.longest, ms);
+    if (pacing.budget > 0 && ms > PACING_LATE * pacing.budget * 1000)
+        pacing.late++;
+}
+
+/* Called right after the buffer swap, capped frames wait here for their slot */
+void paceFrame()
+{
+    if (pacing.mode == PACING_CAPPED)
+    {
+        pacing.deadline += pacing.budget;
+        // More than a frame behind, start the schedule over instead of rushing frames out to catch up
+        if (pacing.deadline < glfwGetTime() - pacing.budget)
+            pacing.deadline = glfwGetTime();
+        else
+            sleepUntil(pacing.deadline);
+    }
+    double now = glfwGetTime();
+    recordFrameTime((now - pacing.lastFrame) * 1000);
+    pacing.lastFrame = now;
+}
+
+void printPacingStats()
+{
+    double deviation = pacing.frames > 1 ? sqrt(pacing.m2 / (pacing.frames - 1)) : 0;
+    printf("pacing: %s", pacingModeNames[pacing.mode]);
+    if (pacing.budget > 0)
+        printf(" (%.1f ms budget)", pacing.budget * 1000);
+    printf(" %ld frames, %.3f ms mean, %.3f ms std dev, %.3f..%.3f ms, %ld late\n", pacing.frames, pacing.mean,
+           deviation, pacing.shortest, pacing.longest, pacing.late);
+    pacing.frames = pacing.late = 0;
+    pacing.mean = pacing.m2 = pacing.shortest = pacing.longest = 0;
+}
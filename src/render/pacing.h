@@ -0,0 +1,48 @@
+#ifndef RENDER_PACING_H
+#define RENDER_PACING_H
+
+#include "common/common.h"
+
+/****************
+ * Frame pacing *
+ ****************/
+
+enum PacingMode
+{
+    PACING_VSYNC = 0, // swap interval 1, one frame per refresh
+    PACING_ADAPTIVE,  // swap interval -1, waits for the refresh unless the frame is already late
+    PACING_UNCAPPED,  // swap interval 0, as many frames as the machine makes
+    PACING_CAPPED,    // swap interval 0 and sleeping until the next frame of a fixed rate
+};
+
+/* The scheduler can oversleep by a millisecond or more, capped frames sleep
+ * until this close to their deadline and spin the rest */
+#define PACING_SPIN 0.002
+/* A frame counts as late when it takes this many frame budgets */
+#define PACING_LATE 1.5
+
+struct FramePacing
+{
+    PacingMode mode;
+    bool chosen;      // set on the command line, headless runs otherwise go uncapped
+    double capHz;     // frame rate of PACING_CAPPED
+    double refreshHz; // of the primary monitor, the budget of the vsync modes
+    double budget;    // seconds per frame the mode aims for, 0 when uncapped
+    double deadline;  // when the next capped frame is due
+    double lastFrame;
+
+    // Swap to swap frame times since the statistics were last printed, in milliseconds
+    long frames;
+    double mean, m2; // running mean and sum of squared differences from it (Welford)
+    double shortest, longest;
+    long late;
+};
+
+extern FramePacing pacing;
+
+bool parsePacingMode(const char *name);
+void startFramePacing();
+void paceFrame();
+void printPacingStats();
+
+#endif
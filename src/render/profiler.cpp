@@ -0,0 +1,90 @@
+#include "render/profiler.h"
+
+const char *renderLayerNames[NUM_RENDER_LAYERS] = {"shadow", "block", "tiles", "fragile tiles", "teleporters", "switches", "bridges", "hud"};
+
+FrameStats frameStats;
+
+struct GpuTimerFrame
+{
+    GLuint queries[2 * MAX_PASS_SAMPLES];
+    int layer[MAX_PASS_SAMPLES];
+    int samples;
+};
+
+GpuTimerFrame gpuTimerFrames[GPU_TIMER_FRAMES];
+int gpuTimerFrame = 0;
+double passCpuTime[NUM_RENDER_LAYERS];
+double passCpuStart;
+
+double smoothTiming(double average, double sample)
+{
+    return average == 0 ? sample : average * 0.9 + sample * 0.1;
+}
+
+void initGpuTimers()
+{
+    for (int i = 0; i < GPU_TIMER_FRAMES; i++)
+    {
+        glGenQueries(2 * MAX_PASS_SAMPLES, gpuTimerFrames[i].queries);
+        gpuTimerFrames[i].samples = 0;
+    }
+}
+
+/* Move to the next query slot, collecting its results from GPU_TIMER_FRAMES - 1 frames ago */
+void beginGpuTimerFrame()
+{
+    gpuTimerFrame = (gpuTimerFrame + 1) % GPU_TIMER_FRAMES;
+    GpuTimerFrame &frame = gpuTimerFrames[gpuTimerFrame];
+
+    if (frame.samples > 0)
+    {
+        GLint available = 0;
+        glGetQueryObjectiv(frame.queries[2 * frame.samples - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available)
+        {
+            double gpuTime[NUM_RENDER_LAYERS] = {};
+            for (int i = 0; i < frame.samples; i++)
+            {
+                GLuint64 start, end;
+                glGetQueryObjectui64v(frame.queries[2 * i], GL_QUERY_RESULT, &start);
+                glGetQueryObjectui64v(frame.queries[2 * i + 1], GL_QUERY_RESULT, &end);
+                gpuTime[frame.layer[i]] += (end - start) / 1e6;
+            }
+            for (int i = 0; i < NUM_RENDER_LAYERS; i++)
+                frameStats.pass[i].gpu = smoothTiming(frameStats.pass[i].gpu, gpuTime[i]);
+            frameStats.gpuFramesRead++;
+        }
+        else
+            frameStats.gpuFramesDropped++;
+    }
+    frame.samples = 0;
+    memset(passCpuTime, 0, sizeof(passCpuTime));
+}
+
+/* Returns the sample to close with endPassTimer, -1 when the frame is out of query slots */
+int beginPassTimer(int layer)
+{
+    GpuTimerFrame &frame = gpuTimerFrames[gpuTimerFrame];
+    if (frame.samples >= MAX_PASS_SAMPLES)
+        return -1;
+    int sample = frame.samples++;
+    frame.layer[sample] = layer;
+    glQueryCounter(frame.queries[2 * sample], GL_TIMESTAMP);
+    passCpuStart = glfwGetTime();
+    return sample;
+}
+
+void endPassTimer(int sample)
+{
+    if (sample < 0)
+        return;
+    GpuTimerFrame &frame = gpuTimerFrames[gpuTimerFrame];
+    glQueryCounter(frame.queries[2 * sample + 1], GL_TIMESTAMP);
+    passCpuTime[frame.layer[sample]] += (glfwGetTime() - passCpuStart) * 1000;
+}
+
+void endGpuTimerFrame()
+{
+    for (int i = 0; i < NUM_RENDER_LAYERS; i++)
+        frameStats.pass[i].cpu = smoothTiming(frameStats.pass[i].cpu, passCpuTime[i]);
+}
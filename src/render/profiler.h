@@ -0,0 +1,58 @@
+#ifndef RENDER_PROFILER_H
+#define RENDER_PROFILER_H
+
+#include "common/common.h"
+
+/* Render passes, drawn in this order */
+enum RenderLayer
+{
+    LAYER_SHADOW = 0, // depth from the light, drawn from the queue before the views
+    LAYER_BLOCK,
+    LAYER_TILES,
+    LAYER_FRAGILE_TILES,
+    LAYER_TELEPORTERS,
+    LAYER_SWITCHES,
+    LAYER_BRIDGES,
+    LAYER_HUD,
+    NUM_RENDER_LAYERS
+};
+
+extern const char *renderLayerNames[NUM_RENDER_LAYERS];
+
+/******************
+ * Frame profiler *
+ ******************/
+
+/* Every render pass (one layer of the queue in one view) is bracketed by two GL_TIMESTAMP
+ * queries. Results are read GPU_TIMER_FRAMES - 1 frames later, when the query slots are
+ * about to be reused, and only if they are already available so the CPU never waits */
+#define GPU_TIMER_FRAMES 4
+#define MAX_PASS_SAMPLES 32
+
+/* Milliseconds, smoothed over the last frames */
+struct PassTiming
+{
+    double cpu;
+    double gpu;
+};
+
+struct FrameStats
+{
+    double frameCpu; // draw and HUD update, without the buffer swap
+    double simCpu;   // the latest batch of ticks on the simulation thread, not part of frameCpu
+    double sceneCpu; // camera and render queue submission in draw()
+    double frameCpuPeak; // worst unsmoothed frameCpu since the stats were last printed
+    PassTiming pass[NUM_RENDER_LAYERS];
+    int gpuFramesRead, gpuFramesDropped;
+};
+
+extern FrameStats frameStats;
+
+double smoothTiming(double average, double sample);
+void initGpuTimers();
+void beginGpuTimerFrame();
+int beginPassTimer(int layer);
+void endPassTimer(int sample);
+void endGpuTimerFrame();
+
+#endif
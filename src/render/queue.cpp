@@ -0,0 +1,279 @@
+#include "render/queue.h"
+#include "render/camera.h"
+
+vector<ProgramUniforms> programUniforms;
+
+MultiViewProgram multiView;
+
+vector<RenderCommand> renderQueue;
+glm::mat4 renderQueueSortVP;
+RenderStats renderStats, lastRenderStats;
+ViewportState boundViewport;
+
+/* Split screen still changes it per view, a single view sets it once per resize */
+void setViewport(int x, int y, int width, int height)
+{
+    ViewportState &v = boundViewport;
+    if (v.valid && v.x == x && v.y == y && v.width == width && v.height == height)
+        return;
+    glViewport(x, y, width, height);
+    ViewportState viewport = {x, y, width, height, true};
+    boundViewport = viewport;
+}
+
+void registerProgram(GLuint program)
+{
+    ProgramUniforms uniforms = {program, glGetUniformLocation(program, "MVP"), glGetUniformLocation(program, "M")};
+    programUniforms.push_back(uniforms);
+}
+
+const ProgramUniforms *findProgramUniforms(GLuint program)
+{
+    for (size_t i = 0; i < programUniforms.size(); i++)
+        if (programUniforms[i].program == program)
+            return &programUniforms[i];
+    return NULL;
+}
+
+bool compareRenderCommands(const RenderCommand &a, const RenderCommand &b)
+{
+    return a.key < b.key;
+}
+
+unsigned long long fillModeBits(GLenum fill_mode)
+{
+    if (fill_mode == GL_LINE)
+        return 1;
+    if (fill_mode == GL_POINT)
+        return 2;
+    return 0;
+}
+
+/* Start a new frame of submissions, VP is only used to order draws by depth */
+void beginRenderQueue(const glm::mat4 &VP)
+{
+    renderQueue.clear();
+    renderQueueSortVP = VP;
+}
+
+/* Queue a VAO to be drawn with the given shader program, model matrix and color */
+void submit3DObject(GLuint program, VAO *vao, const glm::mat4 &model, COLOR color, int layer, GLuint texture)
+{
+    // Depth of the object origin in NDC, front to back inside a state bucket
+    glm::vec4 clip = renderQueueSortVP * model * glm::vec4(0, 0, 0, 1);
+    float depth = clip.w != 0 ? clip.z / clip.w : clip.z;
+    depth = depth * 0.5f + 0.5f;
+    if (depth < 0)
+        depth = 0;
+    if (depth > 1)
+        depth = 1;
+
+    RenderCommand command;
+    command.key = ((unsigned long long)(layer & 0xF) << 60) |
+                  ((unsigned long long)(program & 0xFFF) << 48) |
+                  (fillModeBits(vao->FillMode) << 46) |
+                  ((unsigned long long)(vao->VertexArrayID & 0x3FFFFF) << 24) |
+                  (unsigned long long)(depth * 0xFFFFFF);
+    command.object = vao;
+    command.texture = texture;
+    command.color = color;
+    command.model = model;
+    if (vao->PositionScale != 1)
+    {
+        // Undo the SNORM16 normalization as part of the model transform
+        command.model = model * glm::scale(glm::vec3(vao->PositionScale));
+    }
+    renderQueue.push_back(command);
+}
+
+/* Draw the sorted queue once, skipping any state that is already bound
+ * With a VP the queue's own programs are used and MVP is uploaded per draw, skipLayered leaves out the draws
+ * of multiView.source. Without one only those draws are made, with the multi view program and M per draw */
+void replayRenderQueue(const glm::mat4 *VP, bool skipLayered)
+{
+    GLuint boundProgram = VP ? 0 : multiView.programID;
+    GLenum boundFillMode = 0;
+    GLuint boundVAO = 0;
+    GLuint boundTexture = 0;
+    bool colorValid = false; // the current color attribute value is unknown until set
+    COLOR boundColor = {0, 0, 0};
+    GLint MatrixID = Matrices.MatrixID, ModelID = Matrices.ModelID;
+    int currentLayer = -1, passSample = -1;
+
+    for (size_t i = 0; i < renderQueue.size(); i++)
+    {
+        RenderCommand &command = renderQueue[i];
+        VAO *vao = command.object;
+        GLuint program = (GLuint)((command.key >> 48) & 0xFFF);
+        bool layered = program == (multiView.source & 0xFFF);
+        if (VP ? skipLayered && layered : !layered)
+            continue;
+
+        // Layers are contiguous in the sorted queue, time each one as a pass
+        int layer = (int)(command.key >> 60);
+        if (layer != currentLayer)
+        {
+            endPassTimer(passSample);
+            passSample = beginPassTimer(layer);
+            currentLayer = layer;
+        }
+        if (!VP)
+            program = multiView.programID;
+
+        if (program != boundProgram)
+        {
+            glUseProgram(program);
+            boundProgram = program;
+            renderStats.programBinds++;
+            const ProgramUniforms *uniforms = findProgramUniforms(program);
+            if (uniforms)
+            {
+                MatrixID = uniforms->MatrixID;
+                ModelID = uniforms->ModelID;
+            }
+        }
+        else
+            renderStats.programBindsSkipped++;
+
+        if (vao->FillMode != boundFillMode)
+        {
+            glPolygonMode(GL_FRONT_AND_BACK, vao->FillMode);
+            boundFillMode = vao->FillMode;
+            renderStats.fillModeChanges++;
+        }
+        else
+            renderStats.fillModeChangesSkipped++;
+
+        if (vao->VertexArrayID != boundVAO)
+        {
+            glBindVertexArray(vao->VertexArrayID);
+            boundVAO = vao->VertexArrayID;
+            renderStats.vaoBinds++;
+        }
+        else
+            renderStats.vaoBindsSkipped++;
+
+        if (command.texture && command.texture != boundTexture)
+        {
+            glBindTexture(GL_TEXTURE_2D, command.texture);
+            boundTexture = command.texture;
+        }
+
+        // The color is a constant attribute of the draw, like a per instance attribute with one instance
+        // Drawing with a color array leaves the current value undefined
+        if (vao->VertexColors)
+            colorValid = false;
+        else if (!colorValid || command.color.r != boundColor.r || command.color.g != boundColor.g || command.color.b != boundColor.b)
+        {
+            glVertexAttrib3f(1, command.color.r, command.color.g, command.color.b);
+            boundColor = command.color;
+            colorValid = true;
+            renderStats.colorChanges++;
+        }
+        else
+            renderStats.colorChangesSkipped++;
+
+        if (VP)
+        {
+            glm::mat4 MVP = (*VP) * command.model; // MVP = p * V * M
+            glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP[0][0]);
+            glUniformMatrix4fv(ModelID, 1, GL_FALSE, &command.model[0][0]);
+        }
+        else
+        {
+            glUniformMatrix4fv(multiView.ModelID, 1, GL_FALSE, &command.model[0][0]);
+        }
+        drawGeometry(vao);
+        renderStats.draws++;
+    }
+    endPassTimer(passSample);
+}
+
+/* Draw the queued commands of the layers in layerMask with the program already bound, for depth only
+ * passes such as the shadow map. Textured commands (chunk impostors) are left out */
+void drawQueuedCasters(const glm::mat4 &VP, GLint MatrixID, unsigned int layerMask)
+{
+    GLuint boundVAO = 0;
+    for (size_t i = 0; i < renderQueue.size(); i++)
+    {
+        RenderCommand &command = renderQueue[i];
+        int layer = (int)(command.key >> 60);
+        if (!(layerMask & (1u << layer)) || command.texture)
+            continue;
+        if (command.object->VertexArrayID != boundVAO)
+        {
+            glBindVertexArray(command.object->VertexArrayID);
+            boundVAO = command.object->VertexArrayID;
+        }
+        glm::mat4 MVP = VP * command.model;
+        glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP[0][0]);
+        drawGeometry(command.object);
+    }
+}
+
+/* Sort the queue once and render it into every view
+ * The traversal and model matrices are shared, only VP changes between views */
+void executeRenderQueue(const vector<RenderView> &views, void (*extraPass)(const RenderView &view))
+{
+    sort(renderQueue.begin(), renderQueue.end(), compareRenderCommands);
+    memset(&renderStats, 0, sizeof(renderStats));
+    renderStats.views = views.size();
+
+    if (views.size() > 1 && views.size() <= MAX_RENDER_VIEWS && multiView.programID)
+    {
+        // Layered path: one draw per object, instanced across the viewports by the geometry shader
+        glm::mat4 VP[MAX_RENDER_VIEWS];
+        for (size_t i = 0; i < views.size(); i++)
+        {
+            glViewportIndexedf(i, views[i].x, views[i].y, views[i].width, views[i].height);
+            boundViewport.valid = false;
+            VP[i] = views[i].VP;
+        }
+        glUseProgram(multiView.programID);
+        glUniformMatrix4fv(multiView.VPID, views.size(), GL_FALSE, &VP[0][0][0]);
+        glUniform1i(multiView.ViewCountID, views.size());
+        replayRenderQueue(NULL);
+        // Draws with programs that have no layered variant, like textured impostors, keep their own program per view
+        bool others = false;
+        for (size_t i = 0; i < renderQueue.size() && !others; i++)
+            others = ((renderQueue[i].key >> 48) & 0xFFF) != (multiView.source & 0xFFF);
+        for (size_t i = 0; i < views.size() && (others || extraPass); i++)
+        {
+            setViewport(views[i].x, views[i].y, views[i].width, views[i].height);
+            if (others)
+                replayRenderQueue(&views[i].VP, true);
+            if (extraPass)
+                extraPass(views[i]);
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < views.size(); i++)
+        {
+            setViewport(views[i].x, views[i].y, views[i].width, views[i].height);
+            replayRenderQueue(&views[i].VP);
+            // Draws that bypass the queue, inside the frame's pass timers
+            if (extraPass)
+                extraPass(views[i]);
+        }
+    }
+
+    renderQueue.clear();
+    lastRenderStats = renderStats;
+}
+
+void printRenderStats()
+{
+    cout << "views: " << lastRenderStats.views
+         << " draws: " << lastRenderStats.draws
+         << " program binds: " << lastRenderStats.programBinds << " (skipped " << lastRenderStats.programBindsSkipped << ")"
+         << " fill mode changes: " << lastRenderStats.fillModeChanges << " (skipped " << lastRenderStats.fillModeChangesSkipped << ")"
+         << " VAO binds: " << lastRenderStats.vaoBinds << " (skipped " << lastRenderStats.vaoBindsSkipped << ")"
+         << " colors: " << lastRenderStats.colorChanges << " (skipped " << lastRenderStats.colorChangesSkipped << ")" << endl;
+    printf("frame cpu: %.3f ms  sim cpu: %.3f ms  scene cpu: %.3f ms  gpu frames read: %d dropped: %d\n",
+           frameStats.frameCpu, frameStats.simCpu, frameStats.sceneCpu, frameStats.gpuFramesRead, frameStats.gpuFramesDropped);
+    for (int i = 0; i < NUM_RENDER_LAYERS; i++)
+        printf("  %-14s cpu: %.3f ms  gpu: %.3f ms\n", renderLayerNames[i], frameStats.pass[i].cpu, frameStats.pass[i].gpu);
+    printf("peak frame cpu since last print: %.3f ms\n", frameStats.frameCpuPeak);
+    frameStats.frameCpuPeak = 0;
+}
@@ -0,0 +1,84 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include "render/mesh.h"
+#include "render/profiler.h"
+
+/****************
+ * Render queue *
+ ****************/
+
+/* Draws are submitted as 64 bit sort keys and executed once per frame
+ * key = | layer (4) | program (12) | fill mode (2) | VAO (22) | depth (24) |
+ * so the most expensive state changes end up in the highest bits */
+struct RenderCommand
+{
+    unsigned long long key;
+    VAO *object;
+    GLuint texture; // bound to unit 0 for the draw, 0 to leave the unit as it is
+    COLOR color;    // per draw value of the color attribute, unused by meshes with vertex colors
+    glm::mat4 model;
+};
+
+/* Uniform locations of every program the queue can draw with */
+struct ProgramUniforms
+{
+    GLuint program;
+    GLint MatrixID;
+    GLint ModelID;
+};
+
+/* A viewport (in framebuffer pixels) and the view projection used to render into it */
+struct RenderView
+{
+    int x, y, width, height;
+    glm::mat4 VP;
+};
+
+#define MAX_RENDER_VIEWS 4
+
+/* Program rendering every view in one draw, the geometry shader picks gl_ViewportIndex
+ * It is the layered variant of one program, draws queued with any other program are drawn view by view */
+struct MultiViewProgram
+{
+    GLuint programID; // 0 when the GL version has no viewport arrays
+    GLuint source;    // the program it stands in for
+    GLint ModelID;
+    GLint VPID;
+    GLint ViewCountID;
+};
+
+extern MultiViewProgram multiView;
+
+struct RenderStats
+{
+    int draws;
+    int programBinds, programBindsSkipped;
+    int fillModeChanges, fillModeChangesSkipped;
+    int vaoBinds, vaoBindsSkipped;
+    int colorChanges, colorChangesSkipped;
+    int views;
+};
+
+extern RenderStats lastRenderStats;
+
+/* The viewport last set with setViewport, glViewport is only called when it changes */
+struct ViewportState
+{
+    int x, y, width, height;
+    bool valid; // false after something else changed the viewport
+};
+
+extern ViewportState boundViewport;
+
+void setViewport(int x, int y, int width, int height);
+void registerProgram(GLuint program);
+const ProgramUniforms *findProgramUniforms(GLuint program);
+void beginRenderQueue(const glm::mat4 &VP);
+void submit3DObject(GLuint program, VAO *vao, const glm::mat4 &model, COLOR color, int layer, GLuint texture = 0);
+void replayRenderQueue(const glm::mat4 *VP, bool skipLayered = false);
+void drawQueuedCasters(const glm::mat4 &VP, GLint MatrixID, unsigned int layerMask);
+void executeRenderQueue(const vector<RenderView> &views, void (*extraPass)(const RenderView &view) = NULL);
+void printRenderStats();
+
+#endif
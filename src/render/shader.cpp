@@ -0,0 +1,179 @@
+#include "render/shader.h"
+
+/* Function to load Shaders - Use it as it is */
+GLuint LoadShaders(const char *vertex_file_path, const char *fragment_file_path)
+{
+    // Create the shaders
+    GLuint VertexShaderID = glCreateShader(GL_VERTEX_SHADER);
+    GLuint FragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
+
+    // Read the Vertex Shader code from the file
+    std::string VertexShaderCode;
+    std::ifstream VertexShaderStream(vertex_file_path, std::ios::in);
+    if (VertexShaderStream.is_open())
+    {
+        std::string Line = "";
+        while (getline(VertexShaderStream, Line))
+            VertexShaderCode += "\n" + Line;
+        VertexShaderStream.close();
+    }
+
+    // Read the Fragment Shader code from the file
+    std::string FragmentShaderCode;
+    std::ifstream FragmentShaderStream(fragment_file_path, std::ios::in);
+    if (FragmentShaderStream.is_open())
+    {
+        std::string Line = "";
+        while (getline(FragmentShaderStream, Line))
+            FragmentShaderCode += "\n" + Line;
+        FragmentShaderStream.close();
+    }
+
+    GLint Result = GL_FALSE;
+    int InfoLogLength;
+
+    // Compile Vertex Shader
+    //    printf("Compiling shader : %s\n", vertex_file_path);
+    char const *VertexSourcePointer = VertexShaderCode.c_str();
+    glShaderSource(VertexShaderID, 1, &VertexSourcePointer, NULL);
+    glCompileShader(VertexShaderID);
+
+    // Check Vertex Shader
+    glGetShaderiv(VertexShaderID, GL_COMPILE_STATUS, &Result);
+    glGetShaderiv(VertexShaderID, GL_INFO_LOG_LENGTH, &InfoLogLength);
+    std::vector<char> VertexShaderErrorMessage(InfoLogLength);
+    glGetShaderInfoLog(VertexShaderID, InfoLogLength, NULL, &VertexShaderErrorMessage[0]);
+
+    // Compile Fragment Shader
+    //    printf("Compiling shader : %s\n", fragment_file_path);
+    char const *FragmentSourcePointer = FragmentShaderCode.c_str();
+    glShaderSource(FragmentShaderID, 1, &FragmentSourcePointer, NULL);
+    glCompileShader(FragmentShaderID);
+
+    // Check Fragment ShadercreateRectangle("s1", -1.5, -0.7, -0.5, 0.4, 0.4, 0.4, "toggle", 0, grey);
+    glGetShaderiv(FragmentShaderID, GL_COMPILE_STATUS, &Result);
+    glGetShaderiv(FragmentShaderID, GL_INFO_LOG_LENGTH, &InfoLogLength);
+    std::vector<char> FragmentShaderErrorMessage(InfoLogLength);
+    glGetShaderInfoLog(FragmentShaderID, InfoLogLength, NULL, &FragmentShaderErrorMessage[0]);
+    // fprintf(stdout, "%s\n", &FragmentShaderErrorMessage[0]);
+
+    // Link the program
+    // fprintf(stdout, "Linking program\n");
+    GLuint ProgramID = glCreateProgram();
+    glAttachShader(ProgramID, VertexShaderID);
+    glAttachShader(ProgramID, FragmentShaderID);
+    glLinkProgram(ProgramID);
+
+    // Check the program
+    glGetProgramiv(ProgramID, GL_LINK_STATUS, &Result);
+    glGetProgramiv(ProgramID, GL_INFO_LOG_LENGTH, &InfoLogLength);
+    std::vector<char> ProgramErrorMessage(max(InfoLogLength, int(1)));
+    glGetProgramInfoLog(ProgramID, InfoLogLength, NULL, &ProgramErrorMessage[0]);
+    // fprintf(stdout, "%s\n", &ProgramErrorMessage[0]);
+
+    glDeleteShader(VertexShaderID);
+    glDeleteShader(FragmentShaderID);
+
+    return ProgramID;
+}
+
+/* Read a whole shader source file, empty string when it cannot be opened */
+std::string readShaderFile(const char *file_path)
+{
+    std::string Code;
+    std::ifstream Stream(file_path, std::ios::in);
+    if (Stream.is_open())
+    {
+        std::string Line = "";
+        while (getline(Stream, Line))
+            Code += "\n" + Line;
+        Stream.close();
+    }
+    return Code;
+}
+
+/* Compile one shader stage, returns 0 and prints the log on failure */
+GLuint compileShader(GLenum type, const char *file_path)
+{
+    std::string Code = readShaderFile(file_path);
+    GLuint ShaderID = glCreateShader(type);
+    char const *SourcePointer = Code.c_str();
+    glShaderSource(ShaderID, 1, &SourcePointer, NULL);
+    glCompileShader(ShaderID);
+
+    GLint Result = GL_FALSE;
+    int InfoLogLength;
+    glGetShaderiv(ShaderID, GL_COMPILE_STATUS, &Result);
+    if (Result != GL_TRUE)
+    {
+        glGetShaderiv(ShaderID, GL_INFO_LOG_LENGTH, &InfoLogLength);
+        std::vector<char> ErrorMessage(max(InfoLogLength, int(1)));
+        glGetShaderInfoLog(ShaderID, InfoLogLength, NULL, &ErrorMessage[0]);
+        fprintf(stderr, "%s: %s\n", file_path, &ErrorMessage[0]);
+        glDeleteShader(ShaderID);
+        return 0;
+    }
+    return ShaderID;
+}
+
+/* Function to load a program checking every stage, returns 0 if any fails to compile or the program fails to link
+ * geometry_file_path may be NULL for a plain vertex and fragment program */
+GLuint LoadShaders(const char *vertex_file_path, const char *geometry_file_path, const char *fragment_file_path)
+{
+    GLuint VertexShaderID = compileShader(GL_VERTEX_SHADER, vertex_file_path);
+    GLuint GeometryShaderID = geometry_file_path ? compileShader(GL_GEOMETRY_SHADER, geometry_file_path) : 0;
+    GLuint FragmentShaderID = compileShader(GL_FRAGMENT_SHADER, fragment_file_path);
+
+    GLuint ProgramID = 0;
+    if (VertexShaderID && (GeometryShaderID || !geometry_file_path) && FragmentShaderID)
+    {
+        ProgramID = glCreateProgram();
+        glAttachShader(ProgramID, VertexShaderID);
+        if (GeometryShaderID)
+            glAttachShader(ProgramID, GeometryShaderID);
+        glAttachShader(ProgramID, FragmentShaderID);
+        glLinkProgram(ProgramID);
+
+        GLint Result = GL_FALSE;
+        glGetProgramiv(ProgramID, GL_LINK_STATUS, &Result);
+        if (Result != GL_TRUE)
+        {
+            int InfoLogLength;
+            glGetProgramiv(ProgramID, GL_INFO_LOG_LENGTH, &InfoLogLength);
+            std::vector<char> ErrorMessage(max(InfoLogLength, int(1)));
+            glGetProgramInfoLog(ProgramID, InfoLogLength, NULL, &ErrorMessage[0]);
+            fprintf(stderr, "%s: %s\n", vertex_file_path, &ErrorMessage[0]);
+            glDeleteProgram(ProgramID);
+            ProgramID = 0;
+        }
+    }
+
+    glDeleteShader(VertexShaderID);
+    if (GeometryShaderID)
+        glDeleteShader(GeometryShaderID);
+    glDeleteShader(FragmentShaderID);
+
+    return ProgramID;
+}
+
+/* Function to load a compute program (GL 4.3), returns 0 if it fails */
+GLuint LoadComputeShader(const char *compute_file_path)
+{
+    GLuint ComputeShaderID = compileShader(GL_COMPUTE_SHADER, compute_file_path);
+    if (!ComputeShaderID)
+        return 0;
+
+    GLuint ProgramID = glCreateProgram();
+    glAttachShader(ProgramID, ComputeShaderID);
+    glLinkProgram(ProgramID);
+
+    GLint Result = GL_FALSE;
+    glGetProgramiv(ProgramID, GL_LINK_STATUS, &Result);
+    if (Result != GL_TRUE)
+    {
+        glDeleteProgram(ProgramID);
+        ProgramID = 0;
+    }
+    glDeleteShader(ComputeShaderID);
+    return ProgramID;
+}
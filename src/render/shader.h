@@ -0,0 +1,12 @@
+#ifndef RENDER_SHADER_H
+#define RENDER_SHADER_H
+
+#include "common/common.h"
+
+GLuint LoadShaders(const char *vertex_file_path, const char *fragment_file_path);
+std::string readShaderFile(const char *file_path);
+GLuint compileShader(GLenum type, const char *file_path);
+GLuint LoadShaders(const char *vertex_file_path, const char *geometry_file_path, const char *fragment_file_path);
+GLuint LoadComputeShader(const char *compute_file_path);
+
+#endif
@@ -0,0 +1,132 @@
+#include "render/shadow.h"
+#include "render/lighting.h"
+#include "render/shader.h"
+
+ShadowMap shadow = {SHADOW_DEFAULT_SIZE, SHADOW_UPDATE_MOVED};
+
+/* --shadow-update moved|always */
+bool parseShadowUpdate(const char *name)
+{
+    if (!strcmp(name, "moved"))
+        shadow.update = SHADOW_UPDATE_MOVED;
+    else if (!strcmp(name, "always"))
+        shadow.update = SHADOW_UPDATE_ALWAYS;
+    else
+    {
+        fprintf(stderr, "Unknown shadow update %s, expected moved or always\n", name);
+        return false;
+    }
+    return true;
+}
+
+/* Depth texture, framebuffer and program of the map, leaves shadows off when size is 0 or the framebuffer is incomplete
+ * Call after initLighting, the texture stays bound to SHADOW_TEXTURE_UNIT */
+void initShadowMap()
+{
+    if (shadow.size <= 0)
+    {
+        return;
+    }
+    glGenTextures(1, &shadow.texture);
+    glActiveTexture(GL_TEXTURE0 + SHADOW_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, shadow.texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, shadow.size, shadow.size, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+    // Linear filtering of a compared texture averages four depth tests in hardware
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    // Outside the map everything is lit
+    GLfloat border[4] = {1, 1, 1, 1};
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, border);
+    glActiveTexture(GL_TEXTURE0);
+
+    glGenFramebuffers(1, &shadow.framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, shadow.framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, shadow.texture, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    shadow.programID = LoadShaders("Sample_GL_shadow.vert", NULL, "Sample_GL_shadow.frag");
+    if (status != GL_FRAMEBUFFER_COMPLETE || !shadow.programID)
+    {
+        cout << "Cannot render the shadow map, drawing without shadows" << endl;
+        shadow.programID = 0;
+        return;
+    }
+    shadow.MatrixID = glGetUniformLocation(shadow.programID, "MVP");
+    shadow.dirty = true;
+}
+
+/* Casters other than the block changed, e.g. a level was swapped in or a bridge came out */
+void markShadowDirty()
+{
+    shadow.dirty = true;
+}
+
+/* Draw the queued casters from the light into the map if anything it shows changed, after the scene is submitted
+ * and inside the frame's GPU timers. The map covers radius around center, from the light direction
+ * extraCasters draws casters that never go through the queue, with its own program, inside the same offset */
+void updateShadowMap(const glm::mat4 &blockModel, const glm::vec3 &center, float radius,
+                     void (*extraCasters)(const glm::mat4 &lightVP))
+{
+    if (!shadow.programID)
+    {
+        return;
+    }
+    shadow.frames++;
+
+    glm::vec3 direction(lighting.block.direction.x, lighting.block.direction.y, lighting.block.direction.z);
+    float distance = radius + 10; // far enough above the board for a teleporting block
+    glm::mat4 lightView = glm::lookAt(center + direction * distance, center, glm::vec3(0, 1, 0));
+    glm::mat4 lightVP = glm::ortho(-radius, radius, -radius, radius, 0.1f, distance + radius + 1) * lightView;
+
+    bool blockMoved = memcmp(&blockModel, &shadow.lastBlock, sizeof(blockModel)) != 0;
+    bool lightMoved = memcmp(&lightVP, &shadow.lightVP, sizeof(lightVP)) != 0;
+    if (shadow.update == SHADOW_UPDATE_MOVED && !blockMoved && !lightMoved && !shadow.dirty)
+    {
+        return;
+    }
+    shadow.lightVP = lightVP;
+    shadow.lastBlock = blockModel;
+    shadow.dirty = false;
+    shadow.renders++;
+    setShadow(lightVP, 1.0f / shadow.size, SHADOW_BIAS);
+
+    int sample = beginPassTimer(LAYER_SHADOW);
+    glBindFramebuffer(GL_FRAMEBUFFER, shadow.framebuffer);
+    glViewport(0, 0, shadow.size, shadow.size);
+    boundViewport.valid = false;
+    glClear(GL_DEPTH_BUFFER_BIT);
+    glUseProgram(shadow.programID);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    // Slope scaled offset against shadow acne on faces lit at a grazing angle
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(2, 4);
+    drawQueuedCasters(lightVP, shadow.MatrixID, SHADOW_CASTERS);
+    if (extraCasters)
+        extraCasters(lightVP);
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    endPassTimer(sample);
+}
+
+/* The pass's GPU time is averaged over every frame, including the ones that kept the map */
+void printShadowStats()
+{
+    double gpu = 0;
+    for (int i = 0; i < NUM_RENDER_LAYERS; i++)
+        gpu += frameStats.pass[i].gpu;
+    if (!shadow.programID)
+    {
+        printf("shadow: off, %.3f ms gpu per frame\n", gpu);
+        return;
+    }
+    printf("shadow: %dx%d map redrawn %s in %d of %d frames, pass gpu %.3f ms of %.3f ms per frame\n", shadow.size, shadow.size,
+           shadow.update == SHADOW_UPDATE_MOVED ? "on change" : "always", shadow.renders, shadow.frames,
+           frameStats.pass[LAYER_SHADOW].gpu, gpu);
+}
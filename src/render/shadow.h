@@ -0,0 +1,48 @@
+#ifndef RENDER_SHADOW_H
+#define RENDER_SHADOW_H
+
+#include "render/queue.h"
+
+/******************
+ * Shadow mapping *
+ ******************/
+
+/* The block and the tiles are drawn from the directional light into one depth texture, which the lit
+ * shaders compare against with 2x2 filtered lookups. The light never moves, so by default the map is
+ * only redrawn when the block has moved or the tiles under it changed */
+enum ShadowUpdate
+{
+    SHADOW_UPDATE_MOVED = 0, // when the block, the covered area or the casters changed
+    SHADOW_UPDATE_ALWAYS     // every frame, to measure the worst case
+};
+
+#define SHADOW_DEFAULT_SIZE 1024
+#define SHADOW_BIAS 0.0015f       // light space depth, on top of the polygon offset of the pass
+#define SHADOW_FOLLOW_RADIUS 8.0f // world units covered around the block where there is no board to fit
+
+/* Layers drawn into the map, switches and bridges lie in the board and teleporters only glow */
+#define SHADOW_CASTERS ((1u << LAYER_BLOCK) | (1u << LAYER_TILES) | (1u << LAYER_FRAGILE_TILES) | (1u << LAYER_BRIDGES))
+
+struct ShadowMap
+{
+    int size; // texels per side, 0 turns shadows off
+    ShadowUpdate update;
+    GLuint programID; // depth only, 0 while shadows are off
+    GLint MatrixID;
+    GLuint framebuffer, texture;
+    glm::mat4 lightVP;   // of the last render
+    glm::mat4 lastBlock; // block model matrix of the last render
+    bool dirty;          // casters other than the block changed
+    int renders, frames;
+};
+
+extern ShadowMap shadow;
+
+bool parseShadowUpdate(const char *name);
+void initShadowMap();
+void markShadowDirty();
+void updateShadowMap(const glm::mat4 &blockModel, const glm::vec3 &center, float radius,
+                     void (*extraCasters)(const glm::mat4 &lightVP) = NULL);
+void printShadowStats();
+
+#endif
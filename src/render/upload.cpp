@@ -0,0 +1,108 @@
+#include "render/upload.h"
+
+UploadThread *uploader;
+
+void uploadWorker()
+{
+    glfwMakeContextCurrent(uploader->context);
+    for (;;)
+    {
+        MeshUpload *job;
+        {
+            unique_lock<mutex> guard(uploader->lock);
+            uploader->wake.wait(guard, [] { return uploader->quit || !uploader->jobs.empty(); });
+            if (uploader->quit)
+                break;
+            job = uploader->jobs.front();
+            uploader->jobs.pop_front();
+        }
+        uploadMeshBuffers(job->mesh, &job->vertexBuffer, &job->indexBuffer);
+        job->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        // Without a flush the fence may never reach the GPU from this context
+        glFlush();
+        job->uploaded.store(1, memory_order_release);
+    }
+    glfwMakeContextCurrent(NULL);
+}
+
+/* Create the shared context and its worker, uploads stay on the GL thread if the context cannot be made */
+void startUploadThread(GLFWwindow *window)
+{
+    glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+    GLFWwindow *context = glfwCreateWindow(1, 1, "uploads", NULL, window);
+    glfwWindowHint(GLFW_VISIBLE, GL_TRUE);
+    if (!context)
+    {
+        cout << "No shared context for uploads, creating buffers on the render thread" << endl;
+        return;
+    }
+    uploader = new UploadThread();
+    uploader->context = context;
+    uploader->quit = 0;
+    uploader->worker = new thread(uploadWorker);
+}
+
+/* Stop the worker before its context is destroyed with the windows */
+void stopUploadThread()
+{
+    if (!uploader)
+    {
+        return;
+    }
+    {
+        lock_guard<mutex> guard(uploader->lock);
+        uploader->quit = 1;
+    }
+    uploader->wake.notify_one();
+    uploader->worker->join();
+    glfwDestroyWindow(uploader->context);
+    uploader = NULL;
+}
+
+/* Job for queueMeshUpload, pack its mesh with packMesh first, into the same arena if there is one
+ * An arena job is destroyed by collectMeshUpload, so collect every job before resetting its arena */
+MeshUpload *newMeshUpload(Arena *arena)
+{
+    MeshUpload *job = arena ? new (arenaAlloc(*arena, sizeof(MeshUpload), alignof(MeshUpload))) MeshUpload() : new MeshUpload();
+    job->fence = 0;
+    job->uploaded.store(0);
+    job->arena = arena;
+    return job;
+}
+
+/* Hand a packed mesh to the upload thread, called from the GL thread */
+void queueMeshUpload(MeshUpload *job)
+{
+    if (!uploader)
+    {
+        uploadMeshBuffers(job->mesh, &job->vertexBuffer, &job->indexBuffer);
+        job->uploaded.store(1, memory_order_release);
+        return;
+    }
+    {
+        lock_guard<mutex> guard(uploader->lock);
+        uploader->jobs.push_back(job);
+    }
+    uploader->wake.notify_one();
+}
+
+/* VAO of an uploaded mesh, or NULL while its buffers are still on the way; the job is freed once it returns a VAO */
+struct VAO *collectMeshUpload(MeshUpload *job)
+{
+    if (!job->uploaded.load(memory_order_acquire))
+    {
+        return NULL;
+    }
+    if (job->fence)
+    {
+        if (glClientWaitSync(job->fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+            return NULL;
+        glDeleteSync(job->fence);
+    }
+    struct VAO *vao = createMeshVAO(job->mesh, job->vertexBuffer, job->indexBuffer, job->arena);
+    if (job->arena)
+        job->~MeshUpload();
+    else
+        delete job;
+    return vao;
+}
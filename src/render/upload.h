@@ -0,0 +1,41 @@
+#ifndef RENDER_UPLOAD_H
+#define RENDER_UPLOAD_H
+
+#include "render/mesh.h"
+
+/*****************
+ * Upload thread *
+ *****************/
+
+/* Buffer uploads run on a worker owning a hidden window whose context shares objects with the main one
+ * The GL thread queues packed meshes and later picks up the buffers once their fence has signalled,
+ * only wrapping them in a VAO itself. Without a second context uploads happen on the spot instead */
+struct MeshUpload
+{
+    PackedMesh mesh;
+    GLuint vertexBuffer, indexBuffer;
+    GLsync fence;         // 0 for uploads done on the GL thread
+    atomic<int> uploaded; // buffers filled and fence queued
+    Arena *arena;         // holds the job, its packed mesh and the VAO handle, NULL for the heap
+};
+
+/* Allocated once and never freed, a detached worker may still wait on it while the process exits */
+struct UploadThread
+{
+    GLFWwindow *context;
+    thread *worker;
+    mutex lock;
+    condition_variable wake;
+    deque<MeshUpload *> jobs; // guarded by lock
+    int quit;                 // guarded by lock
+};
+
+extern UploadThread *uploader;
+
+void startUploadThread(GLFWwindow *window);
+void stopUploadThread();
+MeshUpload *newMeshUpload(Arena *arena = NULL);
+void queueMeshUpload(MeshUpload *job);
+struct VAO *collectMeshUpload(MeshUpload *job);
+
+#endif
@@ -0,0 +1,183 @@
+#include "sim/block.h"
+
+/* Half extents of the 0.5 x 1 x 0.5 block in each orientation */
+const glm::vec3 blockHalfExtents[NUM_ORIENTATIONS] = {
+    glm::vec3(0.25f, 0.5f, 0.25f),
+    glm::vec3(0.5f, 0.25f, 0.25f),
+    glm::vec3(0.25f, 0.25f, 0.5f)};
+
+/* Unit move direction of each InputEventType */
+const glm::vec3 rollDirections[4] = {
+    glm::vec3(-1, 0, 0),
+    glm::vec3(1, 0, 0),
+    glm::vec3(0, 0, -1),
+    glm::vec3(0, 0, 1)};
+
+RollCase rollTable[NUM_ORIENTATIONS][4];
+BlockRoll blockRoll;
+BlockTeleport blockTeleport;
+BlockState blockState = {0, 0, ORIENT_STANDING};
+glm::vec3 blockPosition(-3.5f, -0.15f, 0);
+
+/* World space center of a block resting in the given state, used for rendering only */
+glm::vec3 blockCenter(const BlockState &state)
+{
+    glm::vec3 center(state.x * 0.5f, BOARD_TOP + blockHalfExtents[state.orientation].y, state.z * 0.5f);
+    if (state.orientation == ORIENT_LYING_X)
+        center.x += 0.25f;
+    else if (state.orientation == ORIENT_LYING_Z)
+        center.z += 0.25f;
+    return center;
+}
+
+/* Put the block upright on a cell */
+void placeBlock(int x, int z)
+{
+    blockState.x = x;
+    blockState.z = z;
+    blockState.orientation = ORIENT_STANDING;
+    blockPosition = blockCenter(blockState);
+}
+
+/* Rotation taking the upright block mesh to the given orientation */
+glm::mat4 orientationMatrix(int orientation)
+{
+    if (orientation == ORIENT_LYING_X)
+        return glm::rotate((float)(M_PI / 2), glm::vec3(0, 0, 1));
+    if (orientation == ORIENT_LYING_Z)
+        return glm::rotate((float)(M_PI / 2), glm::vec3(1, 0, 0));
+    return glm::mat4(1.0f);
+}
+
+void initRollTable()
+{
+    glm::vec3 up(0, 1, 0);
+    for (int o = 0; o < NUM_ORIENTATIONS; o++)
+    {
+        for (int dir = 0; dir < 4; dir++)
+        {
+            RollCase &roll = rollTable[o][dir];
+            glm::vec3 d = rollDirections[dir];
+            glm::vec3 e = blockHalfExtents[o];
+            float a = fabsf(d.x) * e.x + fabsf(d.z) * e.z; // half extent along the move
+
+            roll.pivot = a * d - e.y * up;
+            roll.axis = glm::cross(up, d);
+            // The quarter turn takes up to d and d to -up, so the center ends at
+            // pivot + R(-pivot) = (a + e.y) d + (a - e.y) up, exact without any trigonometry
+            roll.endOffset = (a + e.y) * d + (a - e.y) * up;
+
+            bool alongX = d.x != 0;
+            if (o == ORIENT_STANDING)
+                roll.endOrientation = alongX ? ORIENT_LYING_X : ORIENT_LYING_Z;
+            else if (o == ORIENT_LYING_X)
+                roll.endOrientation = alongX ? ORIENT_STANDING : ORIENT_LYING_X;
+            else
+                roll.endOrientation = alongX ? ORIENT_LYING_Z : ORIENT_STANDING;
+
+            // Anchor cell delta, the center offsets are all exact multiples of 0.25
+            glm::vec3 anchorMove = roll.endOffset + blockCenter(BlockState{0, 0, o}) - blockCenter(BlockState{0, 0, roll.endOrientation});
+            roll.cellDX = (int)lroundf(anchorMove.x * 2);
+            roll.cellDZ = (int)lroundf(anchorMove.z * 2);
+
+            roll.toPivot = glm::translate(roll.pivot);
+            roll.fromPivot = glm::translate(-roll.pivot) * orientationMatrix(o);
+        }
+    }
+}
+
+void startRoll(int direction)
+{
+    blockRoll.active = 1;
+    blockRoll.direction = direction;
+    blockRoll.t = 0;
+    blockRoll.start = blockPosition;
+    blockRoll.orientation = blockState.orientation;
+}
+
+/* Advance the roll by one tick, snapping to the precomputed end state when it completes */
+void updateRoll()
+{
+    if (!blockRoll.active)
+    {
+        return;
+    }
+    blockRoll.t += SIM_TICK / ROLL_DURATION;
+    if (blockRoll.t >= 1)
+    {
+        const RollCase &roll = rollTable[blockRoll.orientation][blockRoll.direction];
+        blockState.x += roll.cellDX;
+        blockState.z += roll.cellDZ;
+        blockState.orientation = roll.endOrientation;
+        blockRoll.active = 0;
+
+        blockPosition = blockCenter(blockState);
+    }
+}
+
+void startTeleport(int exitx, int exitz)
+{
+    blockTeleport.phase = TELEPORT_RISE;
+    blockTeleport.t = 0;
+    blockTeleport.from = blockPosition;
+    blockTeleport.to = blockCenter(BlockState{exitx, exitz, ORIENT_STANDING});
+    blockTeleport.exitx = exitx;
+    blockTeleport.exitz = exitz;
+}
+
+/* Block center at progress t through the current teleport phase */
+glm::vec3 teleportPosition(const BlockTeleport &teleport, float t)
+{
+    glm::vec3 lift(0, TELEPORT_HEIGHT, 0);
+    if (teleport.phase == TELEPORT_RISE)
+        return teleport.from + t * lift;
+    if (teleport.phase == TELEPORT_MOVE)
+        return glm::mix(teleport.from, teleport.to, t) + lift;
+    return teleport.to + (1 - t) * lift;
+}
+
+/* Advance the teleport by one tick, the lattice state moves to the exit once the block has landed */
+void updateTeleport()
+{
+    if (blockTeleport.phase == TELEPORT_NONE)
+    {
+        return;
+    }
+    blockTeleport.t += SIM_TICK / TELEPORT_PHASE_DURATION;
+    if (blockTeleport.t >= 1)
+    {
+        blockTeleport.t = 0;
+        if (blockTeleport.phase == TELEPORT_DESCEND)
+        {
+            blockTeleport.phase = TELEPORT_NONE;
+            placeBlock(blockTeleport.exitx, blockTeleport.exitz);
+            return;
+        }
+        blockTeleport.phase++;
+    }
+    blockPosition = teleportPosition(blockTeleport, blockTeleport.t);
+}
+
+/* Called on the simulation thread */
+BlockPose currentBlockPose()
+{
+    BlockPose pose = {blockPosition, blockState, blockRoll, blockTeleport};
+    return pose;
+}
+
+/* Model matrix of the block, alpha is the fraction of a SIM_TICK the frame is ahead of the pose */
+glm::mat4 blockModelMatrix(const BlockPose &pose, float alpha)
+{
+    if (pose.teleport.phase != TELEPORT_NONE)
+    {
+        float t = min(1.0f, pose.teleport.t + alpha * (float)(SIM_TICK / TELEPORT_PHASE_DURATION));
+        return glm::translate(teleportPosition(pose.teleport, t));
+    }
+    if (!pose.roll.active)
+    {
+        return glm::translate(pose.position) * orientationMatrix(pose.state.orientation);
+    }
+    const RollCase &roll = rollTable[pose.roll.orientation][pose.roll.direction];
+    float t = min(1.0f, pose.roll.t + alpha * (float)(SIM_TICK / ROLL_DURATION));
+    return glm::translate(pose.roll.start) * roll.toPivot * glm::rotate((float)(t * M_PI / 2), roll.axis) * roll.fromPivot;
+}
@@ -0,0 +1,106 @@
+#ifndef SIM_BLOCK_H
+#define SIM_BLOCK_H
+
+#include "sim/input.h"
+
+/****************
+ * Block rolling *
+ ****************/
+
+/* A roll is a 90 degree rotation about the bottom edge of the block facing the move
+ * direction, parameterized by t in [0, 1]. The pivot, axis and end state of each of the
+ * 12 (orientation x direction) cases are computed once, so positions never drift and
+ * rendering any t is a constant time matrix product */
+#define ROLL_DURATION (10 * SIM_TICK) // seconds
+
+enum BlockOrientation
+{
+    ORIENT_STANDING = 0, // long side along y
+    ORIENT_LYING_X,      // long side along x
+    ORIENT_LYING_Z,      // long side along z
+    NUM_ORIENTATIONS
+};
+
+struct RollCase
+{
+    glm::vec3 pivot;     // edge the block turns about, relative to the start center
+    glm::vec3 axis;
+    glm::vec3 endOffset; // end center - start center
+    int endOrientation;
+    int cellDX, cellDZ;  // move of the anchor cell, see BlockState
+    glm::mat4 toPivot;   // T(pivot)
+    glm::mat4 fromPivot; // T(-pivot) * orientation of the start state
+};
+
+struct BlockRoll
+{
+    int active;
+    int direction;   // InputEventType
+    float t;
+    glm::vec3 start; // center at t = 0
+    int orientation; // orientation at t = 0
+};
+
+/* Half extents of the 0.5 x 1 x 0.5 block in each orientation */
+extern const glm::vec3 blockHalfExtents[NUM_ORIENTATIONS];
+
+/* Unit move direction of each InputEventType */
+extern const glm::vec3 rollDirections[4];
+
+/* Authoritative block state on the board lattice, cells are 0.5 units apart
+ * (x, z) is the lowest cell the block covers, lying blocks also cover the next cell along their axis */
+struct BlockState
+{
+    int x, z;
+    int orientation;
+};
+
+#define TELEPORT_PHASE_DURATION (30 * SIM_TICK)
+#define TELEPORT_HEIGHT 2.0f // how far the block rises above the board before moving
+
+/* A teleport rises out of the entry cell, glides over to the exit cell and descends, one phase at a time */
+enum TeleportPhase
+{
+    TELEPORT_NONE,
+    TELEPORT_RISE,
+    TELEPORT_MOVE,
+    TELEPORT_DESCEND
+};
+
+struct BlockTeleport
+{
+    int phase; // TeleportPhase
+    float t;   // progress through the current phase
+    glm::vec3 from, to; // resting centers at the entry and exit cells
+    int exitx, exitz;
+};
+
+extern BlockRoll blockRoll;
+extern BlockTeleport blockTeleport;
+extern BlockState blockState;
+extern glm::vec3 blockPosition; // center in world space, the cube sprite only holds the block's mesh and color
+
+/* Everything drawing the block needs, copied out of the simulation into each snapshot */
+struct BlockPose
+{
+    glm::vec3 position;
+    BlockState state;
+    BlockRoll roll;
+    BlockTeleport teleport;
+};
+
+#define BOARD_TOP -0.65f // y of the top face of the tiles
+
+glm::vec3 blockCenter(const BlockState &state);
+void placeBlock(int x, int z);
+glm::mat4 orientationMatrix(int orientation);
+void initRollTable();
+void startRoll(int direction);
+void updateRoll();
+void startTeleport(int exitx, int exitz);
+glm::vec3 teleportPosition(const BlockTeleport &teleport, float t);
+void updateTeleport();
+BlockPose currentBlockPose();
+glm::mat4 blockModelMatrix(const BlockPose &pose, float alpha);
+
+#endif
@@ -0,0 +1,91 @@
+#include "sim/board.h"
+
+Board board;
+
+/* Board cell of a world space coordinate */
+int worldToCell(float v)
+{
+    return (int)lroundf(v * 2);
+}
+
+int boardIndex(int x, int z)
+{
+    x -= board.minx;
+    z -= board.minz;
+    if (x < 0 || z < 0 || x >= board.width || z >= board.depth)
+        return -1;
+    return z * board.width + x;
+}
+
+unsigned char boardCell(int x, int z)
+{
+    if (board.streamedCell)
+        return board.streamedCell(x, z);
+    int index = boardIndex(x, z);
+    return index < 0 ? 0 : board.cells[index];
+}
+
+/* Empty lattice covering cells minx..maxx x minz..maxz, call before adding the cells of a new level */
+void resetBoard(int minx, int minz, int maxx, int maxz)
+{
+    board.minx = minx;
+    board.minz = minz;
+    board.width = maxx - minx + 1;
+    board.depth = maxz - minz + 1;
+    board.cells.assign(board.width * board.depth, 0);
+    board.switches.clear();
+    board.bridges.clear();
+    board.pressed.clear();
+}
+
+void addBoardCell(int x, int z, unsigned char flag)
+{
+    int index = boardIndex(x, z);
+    if (index >= 0)
+        board.cells[index] |= flag;
+}
+
+void addBoardSwitch(int x, int z, const string &name)
+{
+    int index = boardIndex(x, z);
+    if (index >= 0)
+        board.switches[index] = name;
+}
+
+/* Where the bridge of that name comes out once its switch is pressed, see activateSwitch */
+void addBoardBridge(int x, int z, const string &name)
+{
+    int index = boardIndex(x, z);
+    if (index >= 0)
+        board.bridges[name] = index;
+}
+
+/* Press the switch named name, bringing out the bridge of the same name and its partner name + "2"
+ * Runs on the simulation thread, which only changes the lattice: the renderer shows the pressed switch
+ * and the bridges once the press reaches it through a snapshot, see applySnapshot in level/level.cpp */
+void activateSwitch(const string &name)
+{
+    if (find(board.pressed.begin(), board.pressed.end(), name) == board.pressed.end())
+        board.pressed.push_back(name);
+    string names[2] = {name, name + "2"};
+    for (int i = 0; i < 2; i++)
+    {
+        map<string, int>::const_iterator part = board.bridges.find(names[i]);
+        if (part != board.bridges.end())
+            board.cells[part->second] |= CELL_BRIDGE;
+    }
+}
+
+/* Cells covered by the block, returns how many (1 or 2) */
+int blockCells(const BlockState &state, int cellx[2], int cellz[2])
+{
+    cellx[0] = cellx[1] = state.x;
+    cellz[0] = cellz[1] = state.z;
+    if (state.orientation == ORIENT_STANDING)
+        return 1;
+    if (state.orientation == ORIENT_LYING_X)
+        cellx[1]++;
+    else
+        cellz[1]++;
+    return 2;
+}
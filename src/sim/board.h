@@ -0,0 +1,47 @@
+#ifndef SIM_BOARD_H
+#define SIM_BOARD_H
+
+#include "sim/block.h"
+
+/****************
+ * Board lattice *
+ ****************/
+
+/* Every gameplay check is an exact lookup in a dense grid of cell flags, filled by whoever loads the level
+ * through resetBoard and the add functions below, or read from a streamed world through streamedCell */
+enum CellFlags
+{
+    CELL_TILE = 1,
+    CELL_FRAGILE = 2,    // breaks under a standing block
+    CELL_TELEPORT = 4,
+    CELL_SWITCH = 8,
+    CELL_BRIDGE = 16,    // only set while the bridge is out
+    CELL_GOAL = 32
+};
+
+#define CELL_SUPPORT (CELL_TILE | CELL_FRAGILE | CELL_TELEPORT | CELL_SWITCH | CELL_BRIDGE)
+
+struct Board
+{
+    int minx, minz; // cell of cells[0]
+    int width, depth;
+    vector<unsigned char> cells;
+    map<int, string> switches; // cell index -> toggle name
+    map<string, int> bridges;  // bridge name -> cell index
+    vector<string> pressed;    // switches in the order they were first pressed, for the renderer
+    unsigned char (*streamedCell)(int x, int z); // cells of a streamed world, NULL for a level built into cells
+};
+
+extern Board board;
+
+int worldToCell(float v);
+int boardIndex(int x, int z);
+unsigned char boardCell(int x, int z);
+void resetBoard(int minx, int minz, int maxx, int maxz);
+void addBoardCell(int x, int z, unsigned char flag);
+void addBoardSwitch(int x, int z, const string &name);
+void addBoardBridge(int x, int z, const string &name);
+void activateSwitch(const string &name);
+int blockCells(const BlockState &state, int cellx[2], int cellz[2]);
+
+#endif
@@ -0,0 +1,124 @@
+#include "sim/input.h"
+
+struct InputQueue
+{
+    InputEvent events[INPUT_QUEUE_SIZE];
+    std::atomic<unsigned int> head;
+    std::atomic<unsigned int> tail;
+    std::atomic<unsigned int> dropped;
+} inputQueue;
+
+/* Returns false (and counts the event as dropped) when the queue is full */
+bool pushInputEvent(int type, double time)
+{
+    unsigned int head = inputQueue.head.load(std::memory_order_relaxed);
+    unsigned int tail = inputQueue.tail.load(std::memory_order_acquire);
+    if (head - tail >= INPUT_QUEUE_SIZE)
+    {
+        inputQueue.dropped++;
+        return false;
+    }
+    InputEvent &event = inputQueue.events[head % INPUT_QUEUE_SIZE];
+    event.type = type;
+    event.time = time;
+    inputQueue.head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+bool popInputEvent(InputEvent *event)
+{
+    unsigned int tail = inputQueue.tail.load(std::memory_order_relaxed);
+    unsigned int head = inputQueue.head.load(std::memory_order_acquire);
+    if (tail == head)
+    {
+        return false;
+    }
+    *event = inputQueue.events[tail % INPUT_QUEUE_SIZE];
+    inputQueue.tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+bool inputQueueFull()
+{
+    return inputQueue.head.load(std::memory_order_relaxed) - inputQueue.tail.load(std::memory_order_acquire) >= INPUT_QUEUE_SIZE;
+}
+
+bool inputQueueEmpty()
+{
+    return inputQueue.head.load(std::memory_order_relaxed) == inputQueue.tail.load(std::memory_order_acquire);
+}
+
+/* Input event for a movement key, -1 for any other key */
+int moveForKey(unsigned int key)
+{
+    switch (key)
+    {
+    case 'a':
+        return INPUT_MOVE_LEFT;
+    case 'd':
+        return INPUT_MOVE_RIGHT;
+    case 'w':
+        return INPUT_MOVE_UP;
+    case 's':
+        return INPUT_MOVE_DOWN;
+    default:
+        return -1;
+    }
+}
+
+/* Replay driver: moves read from a file are fed into the input queue as fast as it drains,
+ * or with replayPaced one at a time like a player waiting for each roll to finish */
+string replayMoves;
+size_t replayPosition = 0;
+bool replayPaced = false;
+
+void loadReplay(const char *file_path)
+{
+    std::ifstream ReplayStream(file_path, std::ios::in);
+    if (!ReplayStream.is_open())
+    {
+        fprintf(stderr, "Cannot open replay %s\n", file_path);
+        exit(EXIT_FAILURE);
+    }
+    char c;
+    while (ReplayStream.get(c))
+    {
+        if (moveForKey(c) >= 0)
+            replayMoves += c;
+    }
+}
+
+void feedReplay()
+{
+    while (!replayPaced && replayPosition < replayMoves.size() && !inputQueueFull())
+    {
+        pushInputEvent(moveForKey(replayMoves[replayPosition]), glfwGetTime());
+        replayPosition++;
+    }
+}
+
+/* The next move of a paced replay, pressed now */
+void feedReplayMove()
+{
+    if (replayPosition < replayMoves.size() && inputQueueEmpty())
+    {
+        pushInputEvent(moveForKey(replayMoves[replayPosition]), glfwGetTime());
+        replayPosition++;
+    }
+}
+
+/* Events pushed and popped so far, the render thread compares them through a snapshot */
+unsigned int inputPushed()
+{
+    return inputQueue.head.load(std::memory_order_relaxed);
+}
+
+unsigned int inputTaken()
+{
+    return inputQueue.tail.load(std::memory_order_relaxed);
+}
+
+bool replayFed()
+{
+    return replayPosition == replayMoves.size() && inputQueueEmpty();
+}
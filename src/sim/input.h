@@ -0,0 +1,45 @@
+#ifndef SIM_INPUT_H
+#define SIM_INPUT_H
+
+#include "common/common.h"
+
+/***************
+ * Input queue *
+ ***************/
+
+/* Bounded single producer / single consumer ring of input events
+ * The GLFW callbacks and the replay driver push from the main thread, the simulation thread pops.
+ * head is only written by the producer and tail only by the consumer so no lock is needed */
+#define INPUT_QUEUE_SIZE 64 // must be a power of two
+#define SIM_TICK (1 / 60.0) // seconds, a roll takes 10 ticks
+#define MAX_SIM_TICKS_PER_FRAME 8
+
+enum InputEventType
+{
+    INPUT_MOVE_LEFT = 0,
+    INPUT_MOVE_RIGHT,
+    INPUT_MOVE_UP,
+    INPUT_MOVE_DOWN
+};
+
+struct InputEvent
+{
+    int type;
+    double time; // glfwGetTime() when the key was pressed
+};
+
+extern bool replayPaced;
+
+bool pushInputEvent(int type, double time);
+bool popInputEvent(InputEvent *event);
+bool inputQueueFull();
+bool inputQueueEmpty();
+int moveForKey(unsigned int key);
+void loadReplay(const char *file_path);
+void feedReplay();
+void feedReplayMove();
+unsigned int inputPushed();
+unsigned int inputTaken();
+bool replayFed();
+
+#endif
@@ -0,0 +1,84 @@
+#include "sim/latency.h"
+
+LatencyTracker latency;
+
+/* Called on the simulation thread by the tick that starts a move, blockReady is when the block came to rest */
+void latencyMovePicked(double pressed, double blockReady, long tick)
+{
+    if (pressed < blockReady)
+    {
+        latency.buffered++;
+        return;
+    }
+    unsigned int head = latency.head.load(std::memory_order_relaxed);
+    unsigned int tail = latency.tail.load(std::memory_order_acquire);
+    if (head - tail >= LATENCY_RING_SIZE)
+    {
+        latency.dropped++;
+        return;
+    }
+    LatencySample sample = {pressed, glfwGetTime(), 0, tick};
+    latency.ring[head % LATENCY_RING_SIZE] = sample;
+    latency.head.store(head + 1, std::memory_order_release);
+}
+
+/* Called once the frame's draws have been issued, snapshotTick is the last tick the frame shows */
+void latencyFrameDrawn(long snapshotTick)
+{
+    unsigned int tail = latency.tail.load(std::memory_order_relaxed);
+    unsigned int head = latency.head.load(std::memory_order_acquire);
+    for (; tail != head; tail++)
+        latency.pending.push_back(latency.ring[tail % LATENCY_RING_SIZE]);
+    latency.tail.store(tail, std::memory_order_release);
+
+    for (size_t i = 0; i < latency.pending.size(); i++)
+    {
+        if (latency.pending[i].drawn == 0 && latency.pending[i].tick <= snapshotTick)
+            latency.pending[i].drawn = glfwGetTime();
+    }
+}
+
+/* Called when glfwSwapBuffers returns, moves the frame did not show yet stay pending */
+void latencyFrameSwapped()
+{
+    if (latency.pending.empty())
+        return;
+    double now = glfwGetTime();
+    size_t kept = 0;
+    for (size_t i = 0; i < latency.pending.size(); i++)
+    {
+        const LatencySample &sample = latency.pending[i];
+        if (sample.drawn == 0)
+        {
+            latency.pending[kept++] = sample;
+            continue;
+        }
+        latency.pickup.push_back((sample.pickedUp - sample.pressed) * 1000);
+        latency.draw.push_back((sample.drawn - sample.pressed) * 1000);
+        latency.swap.push_back((now - sample.pressed) * 1000);
+    }
+    latency.pending.resize(kept);
+}
+
+/* Nearest rank percentile */
+double latencyPercentile(vector<double> samples, double percent)
+{
+    if (samples.empty())
+        return 0;
+    sort(samples.begin(), samples.end());
+    size_t rank = (size_t)ceil(percent / 100 * samples.size());
+    return samples[rank > 0 ? rank - 1 : 0];
+}
+
+void printLatencyStats()
+{
+    printf("latency: %d moves (%ld more buffered behind a busy block, %ld dropped), p50/p95/p99 ms from the key press:\n",
+           (int)latency.swap.size(), latency.buffered.load(), latency.dropped.load());
+    const char *names[3] = {"picked up", "drawn", "swapped"};
+    const vector<double> *stages[3] = {&latency.pickup, &latency.draw, &latency.swap};
+    for (int i = 0; i < 3; i++)
+    {
+        printf("  %-10s %7.2f %7.2f %7.2f\n", names[i], latencyPercentile(*stages[i], 50),
+               latencyPercentile(*stages[i], 95), latencyPercentile(*stages[i], 99));
+    }
+}
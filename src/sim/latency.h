@@ -0,0 +1,42 @@
+#ifndef SIM_LATENCY_H
+#define SIM_LATENCY_H
+
+#include "common/common.h"
+
+/***************************
+ * Input to photon latency *
+ ***************************/
+
+/* Every move is followed from the key press through the simulation tick that starts its roll,
+ * the first frame drawn from a snapshot that includes that tick and the return of that frame's
+ * buffer swap, the closest to the photons the program can see. Moves pressed while the block was
+ * still busy wait for it on purpose, they are counted but kept out of the distribution.
+ * The simulation thread hands picked up moves to the render thread through a single producer /
+ * single consumer ring like the input queue */
+#define LATENCY_RING_SIZE 64 // must be a power of two
+
+struct LatencySample
+{
+    double pressed, pickedUp, drawn; // glfwGetTime(), drawn is 0 until a frame shows the roll
+    long tick;                       // simulation tick that started the roll
+};
+
+struct LatencyTracker
+{
+    LatencySample ring[LATENCY_RING_SIZE];
+    std::atomic<unsigned int> head; // written by the simulation thread
+    std::atomic<unsigned int> tail; // written by the render thread
+    vector<LatencySample> pending;
+    vector<double> pickup, draw, swap; // milliseconds from the key press, one entry per move
+    atomic<long> buffered; // counted by the simulation thread
+    atomic<long> dropped;  // picked up moves that found the ring full
+};
+
+extern LatencyTracker latency;
+
+void latencyMovePicked(double pressed, double blockReady, long tick);
+void latencyFrameDrawn(long snapshotTick);
+void latencyFrameSwapped();
+void printLatencyStats();
+
+#endif
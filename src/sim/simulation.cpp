@@ -0,0 +1,142 @@
+#include "sim/simulation.h"
+#include "sim/board.h"
+#include "sim/latency.h"
+
+int score = 0;
+
+float goalx = 2, goalz = 0;
+int telexitx = 7, telexitz = 0; // board cell the teleporter leads to
+
+int levelstate = 0;
+int levelGeneration = 0;
+int blockFalling = 0;
+long simulationTicks = 0;
+int simulationExitCode = -1;
+double blockReadyTime = -1; // when the block last came to rest, -1 while it is busy
+SimulationHooks simulationHooks;
+
+int waitingForLevel()
+{
+    return simulationHooks.levelLoading && simulationHooks.levelLoading();
+}
+
+/* One tick of the game rules */
+void stepSimulation()
+{
+    // The block waits on the goal while the next level loads
+    if (waitingForLevel())
+    {
+        return;
+    }
+
+    // Start the next buffered move once the previous roll has finished
+    // and the block is resting on the board
+    if (!blockRoll.active && !blockFalling && blockTeleport.phase == TELEPORT_NONE)
+    {
+        InputEvent event;
+        if (popInputEvent(&event))
+        {
+            latencyMovePicked(event.time, blockReadyTime, simulationTicks);
+            blockReadyTime = -1;
+            startRoll(event.type);
+            score += 1;
+        }
+    }
+
+    updateRoll();
+    if (blockRoll.active)
+    {
+        // The block rests on its pivot edge until the roll completes
+        return;
+    }
+    if (blockTeleport.phase != TELEPORT_NONE)
+    {
+        updateTeleport();
+        return;
+    }
+
+    int cellx[2], cellz[2];
+    int count = blockCells(blockState, cellx, cellz);
+    int standing = (count == 1);
+    unsigned char under = boardCell(cellx[0], cellz[0]);
+
+    if (standing && (under & CELL_GOAL))
+    {
+        cout << "You've won" << endl;
+        if (board.streamedCell)
+        {
+            simulationExitCode = 0;
+            return;
+        }
+        if (levelstate == 0)
+        {
+            cout << "NEXT LEVEL" << endl;
+        }
+        levelstate++;
+        if (levelstate > 1)
+        {
+            cout<<"That's all folks!"<<endl;
+            simulationExitCode = 0;
+            return;
+        }
+        if (simulationHooks.nextLevel)
+            simulationHooks.nextLevel();
+        return;
+    }
+
+    if (standing && (under & CELL_TELEPORT))
+    {
+        // Rise out of the teleporter and over to its exit over the next ticks
+        startTeleport(telexitx, telexitz);
+        return;
+    }
+
+    int flag = 0;
+    for (int i = 0; i < count; i++)
+    {
+        unsigned char cell = boardCell(cellx[i], cellz[i]);
+        if (cell & CELL_SWITCH)
+        {
+            activateSwitch(board.switches[boardIndex(cellx[i], cellz[i])]);
+        }
+        if (cell & CELL_SUPPORT)
+        {
+            flag = 1;
+        }
+    }
+    if (standing && (under & CELL_FRAGILE))
+    {
+        flag = 0;
+    }
+
+    blockFalling = (flag == 0);
+    if(flag == 0)
+    {
+        blockPosition.y -= 0.03;
+        if(blockPosition.y <= -5)
+        {
+            cout << "GAME OVER" << endl;
+            simulationExitCode = 0;
+        }
+    }
+}
+
+/* Advance the game by one fixed SIM_TICK, nothing changes any more once the game is over */
+void updateSimulation()
+{
+    if (simulationExitCode >= 0)
+    {
+        return;
+    }
+    simulationTicks++;
+    stepSimulation();
+    // Moves pressed from here on didn't have to wait for the block
+    if (blockReadyTime < 0 && simulationIdle())
+        blockReadyTime = glfwGetTime();
+}
+
+/* Nothing left to animate: the block rests on the board and no level is loading */
+bool simulationIdle()
+{
+    return !blockRoll.active && !blockFalling && blockTeleport.phase == TELEPORT_NONE && !waitingForLevel();
+}
@@ -0,0 +1,27 @@
+#ifndef SIM_SIMULATION_H
+#define SIM_SIMULATION_H
+
+#include "common/common.h"
+
+extern int score;
+extern int levelstate;
+extern int levelGeneration; // bumped by every level swap
+extern int blockFalling;
+extern long simulationTicks;
+extern int simulationExitCode; // -1 while playing, the game is over once set
+extern float goalx, goalz;
+extern int telexitx, telexitz; // board cell the teleporter leads to
+
+/* Level loading sits above the simulation, which only reaches it through these, both may be NULL */
+struct SimulationHooks
+{
+    int (*levelLoading)(); // the block waits while it returns non zero
+    void (*nextLevel)();   // the block stands on the goal of a level that is not the last one
+};
+
+extern SimulationHooks simulationHooks;
+
+void updateSimulation();
+bool simulationIdle();
+
+#endif
@@ -0,0 +1,139 @@
+#include "sim/snapshot.h"
+#include "sim/simulation.h"
+#include "sim/input.h"
+
+SnapshotBuffer snapshots;
+SimulationThread *simThread;
+
+/* Copy the simulation state into the back slot and hand it over, called on the simulation thread
+ * or on the render thread while the simulation is parked or not started yet */
+void publishSnapshot(double tickTime, double simCpu)
+{
+    SimSnapshot &snapshot = snapshots.slots[snapshots.back];
+    snapshot.tick = simulationTicks;
+    snapshot.tickTime = tickTime;
+    snapshot.simCpu = simCpu;
+    snapshot.block = currentBlockPose();
+    snapshot.score = score;
+    snapshot.levelGeneration = levelGeneration;
+    snapshot.pressedSwitches.assign(board.pressed.begin(), board.pressed.end());
+    snapshot.idle = simulationIdle();
+    snapshot.inputTaken = inputTaken();
+    snapshot.exitCode = simulationExitCode;
+    snapshots.back = snapshots.middle.exchange(snapshots.back | SNAPSHOT_FRESH, memory_order_acq_rel) & 3;
+}
+
+/* The newest published snapshot, called once per frame on the render thread */
+const SimSnapshot &acquireSnapshot()
+{
+    if (snapshots.middle.load(memory_order_relaxed) & SNAPSHOT_FRESH)
+        snapshots.front = snapshots.middle.exchange(snapshots.front, memory_order_acq_rel) & 3;
+    return snapshots.slots[snapshots.front];
+}
+
+void simulationWorker()
+{
+    double simTime = glfwGetTime(), accumulator = 0;
+    for (;;)
+    {
+        {
+            unique_lock<mutex> guard(simThread->lock);
+            if (simThread->pauseRequested)
+            {
+                simThread->parked = 1;
+                simThread->wake.notify_all();
+                simThread->wake.wait(guard, [] { return simThread->quit || !simThread->pauseRequested; });
+                simThread->parked = 0;
+                // The time spent parked is not made up for
+                simTime = glfwGetTime();
+                accumulator = 0;
+            }
+            if (simThread->quit)
+                break;
+        }
+
+        // After a long stall the backlog is dropped instead of running many ticks at once
+        double start = glfwGetTime();
+        accumulator += start - simTime;
+        simTime = start;
+        int ticks = 0;
+        while (accumulator >= SIM_TICK && ticks < MAX_SIM_TICKS_PER_FRAME)
+        {
+            updateSimulation();
+            accumulator -= SIM_TICK;
+            ticks++;
+        }
+        if (ticks == MAX_SIM_TICKS_PER_FRAME)
+        {
+            accumulator = 0;
+        }
+        if (ticks)
+            publishSnapshot(start - accumulator, (glfwGetTime() - start) * 1000);
+
+        // Sleep until the next tick is due unless the render thread needs us
+        double wait = SIM_TICK - accumulator - (glfwGetTime() - start);
+        if (wait > 0)
+        {
+            unique_lock<mutex> guard(simThread->lock);
+            simThread->wake.wait_for(guard, chrono::duration<double>(wait),
+                                     [] { return simThread->quit || simThread->pauseRequested; });
+        }
+    }
+}
+
+/* Publish the starting state and start ticking, call once the first level is in place */
+void startSimulationThread()
+{
+    snapshots.back = 0;
+    snapshots.middle.store(1);
+    snapshots.front = 2;
+    publishSnapshot(glfwGetTime(), 0);
+    simThread = new SimulationThread();
+    simThread->quit = 0;
+    simThread->pauseRequested = 0;
+    simThread->parked = 0;
+    simThread->worker = new thread(simulationWorker);
+}
+
+void stopSimulationThread()
+{
+    if (!simThread)
+    {
+        return;
+    }
+    {
+        lock_guard<mutex> guard(simThread->lock);
+        simThread->quit = 1;
+    }
+    simThread->wake.notify_all();
+    simThread->worker->join();
+    delete simThread->worker;
+    delete simThread;
+    simThread = NULL;
+}
+
+/* Park the simulation between ticks so the render thread may change its state, returns once it is parked */
+void pauseSimulation()
+{
+    if (!simThread)
+    {
+        return;
+    }
+    unique_lock<mutex> guard(simThread->lock);
+    simThread->pauseRequested = 1;
+    simThread->wake.notify_all();
+    simThread->wake.wait(guard, [] { return simThread->parked != 0; });
+}
+
+void resumeSimulation()
+{
+    if (!simThread)
+    {
+        return;
+    }
+    {
+        lock_guard<mutex> guard(simThread->lock);
+        simThread->pauseRequested = 0;
+    }
+    simThread->wake.notify_all();
+}
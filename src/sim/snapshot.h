@@ -0,0 +1,60 @@
+#ifndef SIM_SNAPSHOT_H
+#define SIM_SNAPSHOT_H
+
+#include "sim/board.h"
+
+/*********************
+ * Simulation thread *
+ *********************/
+
+/* The game rules run on their own thread at fixed SIM_TICKs and publish a snapshot of everything the
+ * renderer needs after each batch of ticks. Snapshots go through three slots: the simulation fills the
+ * back one and swaps it with the middle, the renderer swaps the middle with its front one when a newer
+ * snapshot is waiting, so neither side ever waits on the other. The simulation only parks while a
+ * level is swapped in, the one time the render thread rewrites the sprite maps and the board */
+#define SNAPSHOT_FRESH 4 // set in the middle index while the renderer has not taken that slot
+
+struct SimSnapshot
+{
+    long tick;       // simulationTicks when it was taken
+    double tickTime; // glfwGetTime() the last tick stands for, frames interpolate from here
+    double simCpu;   // milliseconds the batch of ticks took
+    BlockPose block;
+    int score;
+    int levelGeneration;
+    vector<string> pressedSwitches; // board.pressed, the slots keep their storage between snapshots
+    bool idle;           // simulationIdle()
+    unsigned inputTaken; // input events popped so far
+    int exitCode;        // simulationExitCode
+};
+
+struct SnapshotBuffer
+{
+    SimSnapshot slots[3];
+    atomic<int> middle; // slot index, with SNAPSHOT_FRESH
+    int back;           // owned by the simulation thread
+    int front;          // owned by the render thread
+};
+
+/* Created by startSimulationThread and freed by stopSimulationThread once the worker has joined */
+struct SimulationThread
+{
+    thread *worker;
+    mutex lock;
+    condition_variable wake;
+    int quit;           // guarded by lock
+    int pauseRequested; // guarded by lock
+    int parked;         // guarded by lock
+};
+
+extern SnapshotBuffer snapshots;
+extern SimulationThread *simThread;
+
+void publishSnapshot(double tickTime, double simCpu);
+const SimSnapshot &acquireSnapshot();
+void startSimulationThread();
+void stopSimulationThread();
+void pauseSimulation();
+void resumeSimulation();
+
+#endif